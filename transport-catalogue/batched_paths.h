@@ -0,0 +1,239 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace graph {
+
+// Shortest paths from up to LANES sources at once. Every vertex keeps a LANES-wide row of
+// distances, and a relaxation updates the whole row of an edge's target with branchless
+// SIMD code. So one pass over the edge arrays serves all sources.
+// The search is label-correcting: a vertex is scanned again whenever one of its lanes improves.
+// Search() is const, so several threads may run searches over one instance.
+template <typename Weight, size_t LANES = 8>
+class BatchedShortestPaths {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    static constexpr size_t LANES_NUMBER = LANES;
+
+    explicit BatchedShortestPaths(const Graph& graph);
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    // Shortest paths trees of one batch of sources, lane i belongs to sources[i]
+    class Trees {
+    public:
+        size_t GetSourcesCount() const {
+            return sources_.size();
+        }
+
+        VertexId GetSource(size_t lane) const {
+            return sources_.at(lane);
+        }
+
+        std::optional<Weight> GetWeight(size_t lane, VertexId to) const;
+
+        std::optional<RouteInfo> BuildRoute(size_t lane, VertexId to) const;
+
+    private:
+        friend class BatchedShortestPaths;
+
+        Trees(const BatchedShortestPaths& engine, std::vector<VertexId> sources);
+
+        const BatchedShortestPaths& engine_;
+        std::vector<VertexId> sources_;
+        std::vector<Weight> weights_;       // vertex * LANES + lane
+        std::vector<EdgeId> prev_edges_;    // vertex * LANES + lane
+    };
+
+    // At most LANES sources
+    Trees Search(std::vector<VertexId> sources) const;
+
+    size_t GetVertexCount() const {
+        return begins_.size() - 1;
+    }
+
+private:
+    // Relaxes all lanes of an edge's target, returns whether some of them improved
+    static bool RelaxLanes(const Weight* from_weights, Weight edge_weight, EdgeId edge_id,
+                           Weight* target_weights, EdgeId* target_edges);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::has_infinity
+                                        ? std::numeric_limits<Weight>::infinity()
+                                        : std::numeric_limits<Weight>::max() / 2;
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    const Graph& graph_;
+    // Outgoing edges in compressed sparse row form: edges of vertex v are [begins_[v], begins_[v + 1])
+    std::vector<size_t> begins_;
+    std::vector<VertexId> targets_;
+    std::vector<Weight> weights_;
+    std::vector<EdgeId> edge_ids_;
+};
+
+template <typename Weight, size_t LANES>
+BatchedShortestPaths<Weight, LANES>::BatchedShortestPaths(const Graph& graph)
+    : graph_(graph)
+    , begins_(graph.GetVertexCount() + 1, 0)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t edge_count = graph.GetEdgeCount();
+    targets_.reserve(edge_count);
+    weights_.reserve(edge_count);
+    edge_ids_.reserve(edge_count);
+
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            targets_.push_back(edge.to);
+            weights_.push_back(edge.weight);
+            edge_ids_.push_back(edge_id);
+        }
+        begins_[vertex + 1] = targets_.size();
+    }
+}
+
+template <typename Weight, size_t LANES>
+typename BatchedShortestPaths<Weight, LANES>::Trees
+BatchedShortestPaths<Weight, LANES>::Search(std::vector<VertexId> sources) const {
+    if (sources.size() > LANES) {
+        throw std::invalid_argument("BatchedShortestPaths: too many sources in one batch");
+    }
+    return Trees(*this, std::move(sources));
+}
+
+template <typename Weight, size_t LANES>
+BatchedShortestPaths<Weight, LANES>::Trees::Trees(const BatchedShortestPaths& engine,
+                                                  std::vector<VertexId> sources)
+    : engine_(engine)
+    , sources_(std::move(sources))
+    , weights_(engine.GetVertexCount() * LANES, UNREACHED)
+    , prev_edges_(engine.GetVertexCount() * LANES, NO_EDGE)
+{
+    const size_t vertex_count = engine.GetVertexCount();
+    std::vector<bool> queued(vertex_count, false);
+    std::deque<VertexId> queue;
+
+    for (size_t lane = 0; lane < sources_.size(); ++lane) {
+        const VertexId source = sources_[lane];
+        weights_.at(source * LANES + lane) = ZERO_WEIGHT;
+        if (!queued[source]) {
+            queued[source] = true;
+            queue.push_back(source);
+        }
+    }
+
+    std::array<Weight, LANES> from_weights;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.front();
+        queue.pop_front();
+        queued[vertex] = false;
+
+        // Copied, so the compiler knows the row isn't changed by relaxations of a loop edge
+        std::copy_n(weights_.begin() + vertex * LANES, LANES, from_weights.begin());
+
+        for (size_t i = engine.begins_[vertex]; i < engine.begins_[vertex + 1]; ++i) {
+            const Weight edge_weight = engine.weights_[i];
+            const EdgeId edge_id = engine.edge_ids_[i];
+            const VertexId target = engine.targets_[i];
+            Weight* target_weights = weights_.data() + target * LANES;
+            EdgeId* target_edges = prev_edges_.data() + target * LANES;
+
+            if (RelaxLanes(from_weights.data(), edge_weight, edge_id, target_weights, target_edges)
+                && !queued[target]) {
+                queued[target] = true;
+                queue.push_back(target);
+            }
+        }
+    }
+}
+
+template <typename Weight, size_t LANES>
+bool BatchedShortestPaths<Weight, LANES>::RelaxLanes(const Weight* from_weights, Weight edge_weight,
+                                                     EdgeId edge_id, Weight* target_weights,
+                                                     EdgeId* target_edges) {
+#if defined(__SSE2__)
+    // Baseline x86-64 compilers keep the generic loop scalar, as SSE2 has no blend instruction
+    if constexpr (std::is_same_v<Weight, double> && sizeof(EdgeId) == sizeof(double) && LANES % 2 == 0) {
+        const __m128d edge_weights = _mm_set1_pd(edge_weight);
+        const __m128i edge_ids = _mm_set1_epi64x(static_cast<long long>(edge_id));
+        int improved = 0;
+        for (size_t lane = 0; lane < LANES; lane += 2) {
+            const __m128d candidates = _mm_add_pd(_mm_loadu_pd(from_weights + lane), edge_weights);
+            const __m128d currents = _mm_loadu_pd(target_weights + lane);
+            const __m128d is_less = _mm_cmplt_pd(candidates, currents);
+            _mm_storeu_pd(target_weights + lane, _mm_min_pd(candidates, currents));
+
+            __m128i* edges = reinterpret_cast<__m128i*>(target_edges + lane);
+            const __m128i mask = _mm_castpd_si128(is_less);
+            _mm_storeu_si128(edges, _mm_or_si128(_mm_and_si128(mask, edge_ids),
+                                                 _mm_andnot_si128(mask, _mm_loadu_si128(edges))));
+            improved |= _mm_movemask_pd(is_less);
+        }
+        return improved != 0;
+    }
+#endif
+    bool improved = false;
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        const Weight candidate = from_weights[lane] + edge_weight;
+        const bool is_less = candidate < target_weights[lane];
+        target_weights[lane] = is_less ? candidate : target_weights[lane];
+        target_edges[lane] = is_less ? edge_id : target_edges[lane];
+        improved |= is_less;
+    }
+    return improved;
+}
+
+template <typename Weight, size_t LANES>
+std::optional<Weight> BatchedShortestPaths<Weight, LANES>::Trees::GetWeight(size_t lane, VertexId to) const {
+    assert(lane < sources_.size());
+    const Weight weight = weights_.at(to * LANES + lane);
+    if (!(weight < UNREACHED)) {
+        return std::nullopt;
+    }
+    return weight;
+}
+
+template <typename Weight, size_t LANES>
+std::optional<typename BatchedShortestPaths<Weight, LANES>::RouteInfo>
+BatchedShortestPaths<Weight, LANES>::Trees::BuildRoute(size_t lane, VertexId to) const {
+    const std::optional<Weight> weight = GetWeight(lane, to);
+    if (!weight) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = prev_edges_[to * LANES + lane];
+         edge_id != NO_EDGE;
+         edge_id = prev_edges_[engine_.graph_.GetEdge(edge_id).from * LANES + lane])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+}  // namespace graph
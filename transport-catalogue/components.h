@@ -0,0 +1,104 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Connected components of the graph with edge directions ignored. Component ids are dense
+// and numbered in order of their smallest vertex. No route leaves its component.
+template <typename Weight>
+std::vector<uint32_t> FindConnectedComponents(const DirectedWeightedGraph<Weight>& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<VertexId> parents(vertex_count);
+    std::iota(parents.begin(), parents.end(), 0);
+
+    auto find_root = [&parents](VertexId vertex) {
+        while (parents[vertex] != vertex) {
+            parents[vertex] = parents[parents[vertex]];
+            vertex = parents[vertex];
+        }
+        return vertex;
+    };
+
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const VertexId from_root = find_root(edge.from);
+        const VertexId to_root   = find_root(edge.to);
+        if (from_root != to_root) {
+            parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+        }
+    }
+
+    std::vector<uint32_t> result(vertex_count);
+    uint32_t components_number = 0;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const VertexId root = find_root(vertex);
+        result[vertex] = root == vertex ? components_number++ : result[root];
+    }
+    return result;
+}
+
+// Dense numbering of vertex pairs lying in one component. Pairs of a component with c
+// vertexes take a contiguous block of c * c indexes, row-major by local vertex ids.
+class ComponentPairsIndex {
+public:
+    ComponentPairsIndex() = default;
+
+    explicit ComponentPairsIndex(std::vector<uint32_t> components)
+        : components_(std::move(components))
+        , local_ids_(components_.size())
+    {
+        for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+            const uint32_t component = components_[vertex];
+            if (component >= sizes_.size()) {
+                sizes_.resize(component + 1, 0);
+            }
+            local_ids_[vertex] = sizes_[component]++;
+        }
+
+        block_begins_.resize(sizes_.size());
+        for (size_t component = 0; component < sizes_.size(); ++component) {
+            block_begins_[component] = pairs_count_;
+            pairs_count_ += static_cast<size_t>(sizes_[component]) * sizes_[component];
+        }
+    }
+
+    // std::nullopt if vertexes lie in different components and so have no route
+    std::optional<size_t> GetIndex(VertexId from, VertexId to) const {
+        const uint32_t component = components_.at(from);
+        if (component != components_.at(to)) {
+            return std::nullopt;
+        }
+        return block_begins_[component] + static_cast<size_t>(local_ids_[from]) * sizes_[component]
+               + local_ids_[to];
+    }
+
+    size_t GetPairsCount() const {
+        return pairs_count_;
+    }
+
+    size_t GetVertexCount() const {
+        return components_.size();
+    }
+
+    const std::vector<uint32_t>& GetComponents() const {
+        return components_;
+    }
+
+private:
+    std::vector<uint32_t> components_;
+    std::vector<uint32_t> local_ids_;
+    std::vector<uint32_t> sizes_;
+    std::vector<size_t> block_begins_;
+    size_t pairs_count_ = 0;
+};
+
+}  // namespace graph
@@ -5,9 +5,11 @@
 #include <string_view>
 #include <vector>
 #include <deque>
+#include <iterator>
 #include <unordered_map>
 #include <set>
 #include "geo.h"
+#include "ranges.h"
 #include <variant>
 
 namespace domain {
@@ -17,16 +19,110 @@ struct DistanceInfo {
     double curvature   = 0;
 };
 
+// Names are views of the catalogue's string pool, or of a base being read
 struct Stop {
-    std::string name;
+    std::string_view name;
     geo::Coordinates coordinates;
+    // Position among stops of the catalogue
+    size_t index = 0;
+};
+
+// Stops of a route in the order a bus visits them. Non-roundtrip routes are stored one way,
+// the view walks them forward and then back, passing the turnaround stop once.
+template <typename StopRef>
+class RouteView {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = StopRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const StopRef*;
+        using reference = const StopRef&;
+
+        Iterator(const std::vector<StopRef>* stops, size_t index) : stops_(stops), index_(index) {}
+
+        reference operator*() const {
+            return GetStop(*stops_, index_);
+        }
+
+        pointer operator->() const {
+            return &GetStop(*stops_, index_);
+        }
+
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++index_;
+            return result;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return index_ != other.index_;
+        }
+
+    private:
+        const std::vector<StopRef>* stops_;
+        size_t index_;
+    };
+
+    // An empty route
+    RouteView() : RouteView(EMPTY, true) {}
+
+    RouteView(const std::vector<StopRef>& stops, bool is_roundtrip) : stops_(&stops), is_roundtrip_(is_roundtrip) {}
+
+    size_t size() const {
+        return is_roundtrip_ || stops_->empty() ? stops_->size() : stops_->size() * 2 - 1;
+    }
+
+    bool empty() const {
+        return stops_->empty();
+    }
+
+    const StopRef& operator[](size_t index) const {
+        return GetStop(*stops_, index);
+    }
+
+    Iterator begin() const {
+        return {stops_, 0};
+    }
+
+    Iterator end() const {
+        return {stops_, size()};
+    }
+
+private:
+    // Indexes past the stored stops go back from the turnaround one
+    static const StopRef& GetStop(const std::vector<StopRef>& stops, size_t index) {
+        return index < stops.size() ? stops[index] : stops[2 * (stops.size() - 1) - index];
+    }
+
+    static inline const std::vector<StopRef> EMPTY;
+
+    const std::vector<StopRef>* stops_;
+    bool is_roundtrip_;
 };
 
 struct Bus {
-    std::string name;
+    std::string_view name;
+    // One way for non-roundtrip buses
     std::vector<Stop*> stops;
     int unique_stops;
     bool is_roundtrip;
+    // Position among buses of the catalogue
+    size_t index = 0;
+
+    RouteView<Stop*> GetRoute() const {
+        return {stops, is_roundtrip};
+    }
 };
 
 struct StopRequest {
@@ -43,27 +139,43 @@ struct BusRequest {
 
 struct StopInfo {
     std::string_view name;
-    const std::set<std::string_view>& buses;
+    // Sorted by name
+    std::vector<std::string_view> buses;
     bool was_found;
 };
 
-struct BusInfo {
+// Buses stopping at both stops
+struct DirectBusesInfo {
+    std::string_view from;
+    std::string_view to;
+    // Sorted by name
+    std::vector<std::string_view> buses;
+    bool was_found;
+};
+
+struct NearbyStop {
     std::string_view name;
-    std::vector<std::string_view> stops;
-    DistanceInfo length;
-    int unique_stops;
+    // Great-circle distance in meters
+    double distance;
 };
 
-struct BusForRender {
+struct NameSuggestion {
     std::string_view name;
-    std::vector<std::string_view> stops;
-    bool is_roundtrip;
+    bool is_bus;
+};
 
-    bool operator<(const BusForRender& other) const {
-        return name < other.name;
-    }
+// Stops are a view of the catalogue's bus, empty if the bus is not found
+struct BusInfo {
+    std::string_view name;
+    RouteView<Stop*> stops;
+    DistanceInfo length;
+    int unique_stops;
 };
 
+// Views of the catalogue's storage, valid until stops or buses are added to it
+using StopsUsed = ranges::Range<std::vector<std::pair<std::string_view, geo::Coordinates>>::const_iterator>;
+using BusesForRender = ranges::Range<std::vector<const Bus*>::const_iterator>;
+
 struct Point {
     Point() = default;
     Point(double x, double y)
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace container {
+
+// Bits in 64-bit words, growing as bits are set. Intersections AND two words per SSE2
+// instruction where it is available.
+class DynamicBitset {
+public:
+    DynamicBitset() = default;
+
+    void Set(size_t index) {
+        const size_t word = index / WORD_BITS;
+        if (word >= words_.size()) {
+            words_.resize(word + 1, 0);
+        }
+        words_[word] |= uint64_t{1} << (index % WORD_BITS);
+    }
+
+    bool Test(size_t index) const {
+        const size_t word = index / WORD_BITS;
+        return word < words_.size() && (words_[word] >> (index % WORD_BITS) & 1) != 0;
+    }
+
+    size_t Count() const {
+        size_t result = 0;
+        for (uint64_t word : words_) {
+            result += CountBits(word);
+        }
+        return result;
+    }
+
+    bool None() const {
+        for (uint64_t word : words_) {
+            if (word != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Calls action(index) for set bits in increasing order
+    template <typename Action>
+    void ForEachSet(Action action) const {
+        for (size_t i = 0; i < words_.size(); ++i) {
+            for (uint64_t word = words_[i]; word != 0; word &= word - 1) {
+                action(i * WORD_BITS + GetLowestBit(word));
+            }
+        }
+    }
+
+    // Bits set in both, the result is as long as the shorter one
+    static DynamicBitset Intersect(const DynamicBitset& lhs, const DynamicBitset& rhs) {
+        const size_t size = std::min(lhs.words_.size(), rhs.words_.size());
+        DynamicBitset result;
+        result.words_.resize(size);
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 2 <= size; i += 2) {
+            const __m128i lhs_words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.words_.data() + i));
+            const __m128i rhs_words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.words_.data() + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result.words_.data() + i), _mm_and_si128(lhs_words, rhs_words));
+        }
+#endif
+        for (; i < size; ++i) {
+            result.words_[i] = lhs.words_[i] & rhs.words_[i];
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t WORD_BITS = 64;
+
+    static size_t CountBits(uint64_t word) {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_popcountll(word));
+#else
+        size_t result = 0;
+        for (; word != 0; word &= word - 1) {
+            ++result;
+        }
+        return result;
+#endif
+    }
+
+    static size_t GetLowestBit(uint64_t word) {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_ctzll(word));
+#else
+        size_t result = 0;
+        for (; (word & 1) == 0; word >>= 1) {
+            ++result;
+        }
+        return result;
+#endif
+    }
+
+    std::vector<uint64_t> words_;
+};
+
+} // namespace container
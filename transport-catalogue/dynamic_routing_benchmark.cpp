@@ -0,0 +1,194 @@
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include "json_reader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Reads make_base requests from stdin, then changes road distances one by one and brings
+// the router up to date by TransportRouter::UpdateBus() of buses driving that road.
+// Reports update and query times against building the router from scratch, and checks
+// that both answer the same route times and that Bus answers see the new distances.
+// Usage: dynamic_routing_benchmark [updates_number] [queries_number] < make_base.json
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double GetMilliseconds(Clock::time_point begin, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+bool IsSameTime(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= 1e-9 * std::max(1.0, std::abs(lhs));
+}
+
+bool DrivesRoad(const domain::Bus& bus, std::string_view from, std::string_view to) {
+    const domain::RouteView<domain::Stop*> stops = bus.GetRoute();
+    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+        const std::string_view lhs = stops[i]->name;
+        const std::string_view rhs = stops[i + 1]->name;
+        if ((lhs == from && rhs == to) || (lhs == to && rhs == from)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t GetRouteLength(const TransportCatalogue& catalogue, const domain::Bus& bus) {
+    const domain::RouteView<domain::Stop*> stops = bus.GetRoute();
+    int64_t result = 0;
+    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+        result += catalogue.GetDistance(stops[i]->name, stops[i + 1]->name);
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t updates_number = argc > 1 ? std::stoul(argv[1]) : 20;
+    const size_t queries_number = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+    stream_input_json::JSONReader reader(std::cin);
+    reader.Read();
+
+    TransportCatalogue catalogue;
+    request_handler::BaseRequestHandler base_handler(catalogue);
+    base_handler.ProcessBaseRequests(reader);
+
+    request_handler::RoutingSettings settings = reader.GetRoutingSettings();
+    settings.time_units_per_minute.reset();
+    settings.landmarks_count.reset();
+    settings.hub_labels = false;
+
+    const request_handler::DistanceComputer distance_computer(catalogue);
+    const domain::BusesForRender buses = catalogue.GetBusesForRender();
+    const request_handler::MapData map_data{catalogue.GetStopsUsed(), buses};
+    if (map_data.stops_used.empty() || buses.empty()) {
+        std::cout << "Routing graph is empty\n";
+        return 0;
+    }
+
+    transport_router::TransportRouter router(settings, distance_computer, map_data, true);
+
+    // Queries come from a few sources, so their trees fit in the router's cache
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> stops(0, map_data.stops_used.size() - 1);
+    std::vector<std::string_view> sources;
+    for (size_t i = 0; i < transport_router::TransportRouter::TREE_CACHE_CAPACITY; ++i) {
+        sources.push_back(map_data.stops_used[stops(generator)].first);
+    }
+    std::uniform_int_distribution<size_t> source_indexes(0, sources.size() - 1);
+    std::vector<std::pair<std::string_view, std::string_view>> queries(queries_number);
+    for (auto& [from, to] : queries) {
+        from = sources[source_indexes(generator)];
+        to = map_data.stops_used[stops(generator)].first;
+    }
+
+    auto answer = [&queries](transport_router::TransportRouter& answering_router) {
+        std::vector<double> result;
+        result.reserve(queries.size());
+        for (const auto& [from, to] : queries) {
+            result.push_back(answering_router.FindRoute(from, to).total_time);
+        }
+        return result;
+    };
+    answer(router);
+    // Bus answers are memoized by the catalogue before distances change
+    for (const domain::Bus* bus : buses) {
+        catalogue.GetBusInfo(bus->name);
+    }
+
+    const std::vector<const domain::Bus*> buses_list = [&buses] {
+        std::vector<const domain::Bus*> result;
+        for (const domain::Bus* bus : buses) {
+            if (bus->stops.size() > 1) {
+                result.push_back(bus);
+            }
+        }
+        return result;
+    }();
+    if (buses_list.empty()) {
+        std::cout << "No bus drives between two stops\n";
+        return 0;
+    }
+    std::uniform_int_distribution<size_t> bus_indexes(0, buses_list.size() - 1);
+    std::uniform_real_distribution<double> factors(0.5, 1.5);
+
+    double update_ms = 0;
+    double updated_queries_ms = 0;
+    double rebuild_ms = 0;
+    double rebuilt_queries_ms = 0;
+    size_t updated_buses = 0;
+    size_t invalidated_trees = 0;
+    size_t mismatches = 0;
+    size_t checked_buses = 0;
+    size_t bus_mismatches = 0;
+
+    for (size_t update = 0; update < updates_number; ++update) {
+        const domain::RouteView<domain::Stop*> stops = buses_list[bus_indexes(generator)]->GetRoute();
+        const size_t index = std::uniform_int_distribution<size_t>(0, stops.size() - 2)(generator);
+        const std::string_view from = stops[index]->name;
+        const std::string_view to = stops[index + 1]->name;
+        const int distance = std::max(1, static_cast<int>(catalogue.GetDistance(from, to) * factors(generator)));
+        catalogue.AddDistance(from, to, distance);
+
+        const Clock::time_point update_begin = Clock::now();
+        for (const domain::Bus* other : buses) {
+            if (DrivesRoad(*other, from, to)) {
+                invalidated_trees += router.UpdateBus(*other).invalidated_trees;
+                ++updated_buses;
+            }
+        }
+        const Clock::time_point update_end = Clock::now();
+        const std::vector<double> updated = answer(router);
+        const Clock::time_point rebuild_begin = Clock::now();
+        transport_router::TransportRouter rebuilt(settings, distance_computer, map_data);
+        const Clock::time_point rebuild_end = Clock::now();
+        const std::vector<double> expected = answer(rebuilt);
+        const Clock::time_point rebuilt_queries_end = Clock::now();
+
+        update_ms += GetMilliseconds(update_begin, update_end);
+        updated_queries_ms += GetMilliseconds(update_end, rebuild_begin);
+        rebuild_ms += GetMilliseconds(rebuild_begin, rebuild_end);
+        rebuilt_queries_ms += GetMilliseconds(rebuild_end, rebuilt_queries_end);
+
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (!IsSameTime(updated[i], expected[i])) {
+                ++mismatches;
+            }
+        }
+        for (const domain::Bus* other : buses) {
+            if (DrivesRoad(*other, from, to)) {
+                ++checked_buses;
+                if (catalogue.GetBusInfo(other->name).length.real_length != GetRouteLength(catalogue, *other)) {
+                    ++bus_mismatches;
+                }
+            }
+        }
+    }
+
+    const transport_router::TransportRouter::EdgesStats stats = router.GetEdgesStats();
+    const double updates_count = std::max<size_t>(1, updates_number);
+    std::cout << "Routing graph: " << map_data.stops_used.size() << " vertexes, " << stats.kept << " edges\n";
+    std::cout << "Updates: " << updates_number << ", buses updated: " << updated_buses
+              << ", cached trees dropped: " << invalidated_trees << "\n";
+    std::cout << "Update: " << update_ms / updates_count << " ms, then "
+              << queries_number << " queries: " << updated_queries_ms / updates_count << " ms\n";
+    std::cout << "Rebuild: " << rebuild_ms / updates_count << " ms, then "
+              << queries_number << " queries: " << rebuilt_queries_ms / updates_count << " ms\n";
+    std::cout << "Mismatches with rebuilt router: " << mismatches << " of " << updates_number * queries_number << "\n";
+    std::cout << "Stale Bus route lengths: " << bus_mismatches << " of " << checked_buses << "\n";
+
+    return mismatches == 0 && bus_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace container {
+
+// Open-addressing hash map in the Swiss table layout. Every slot has a control byte holding
+// 7 bits of its key's hash, or marking it empty or deleted. A lookup compares a whole group
+// of 16 control bytes with one SSE2 instruction where it is available and reads slots only
+// for matching bytes, so a miss usually touches a single cache line.
+// Supports the subset of std::unordered_map used in the project. Unlike std::unordered_map
+// elements live in one flat array, so growth invalidates references to them.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+
+private:
+    static constexpr size_t GROUP_WIDTH = 16;
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    // Control bytes of one group, masks have bit i set for byte i
+    class Group {
+    public:
+        explicit Group(const int8_t* ctrl) : ctrl_(ctrl) {}
+
+        uint32_t Match(int8_t h2) const {
+#if defined(__SSE2__)
+            const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+#else
+            uint32_t result = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+                result |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+            }
+            return result;
+#endif
+        }
+
+        uint32_t MatchEmpty() const {
+            return Match(EMPTY);
+        }
+
+        // Both special values are negative, so the sign bits are the mask
+        uint32_t MatchEmptyOrDeleted() const {
+#if defined(__SSE2__)
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_))));
+#else
+            uint32_t result = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+                result |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+            }
+            return result;
+#endif
+        }
+
+    private:
+        const int8_t* ctrl_;
+    };
+
+    static size_t GetLowestBit(uint32_t mask) {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_ctz(mask));
+#else
+        size_t result = 0;
+        for (; (mask & 1) == 0; mask >>= 1) {
+            ++result;
+        }
+        return result;
+#endif
+    }
+
+    // Standard hashes of integers and pointers are identity, so bits are mixed before
+    // they are split into the group index and the 7 bits kept in control bytes
+    static uint64_t Mix(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    template <bool IsConst>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+
+        // Mutable iterators convert to const ones
+        template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other) : map_(other.map_), index_(other.index_) {}
+
+        reference operator*() const {
+            return map_->slots_[index_];
+        }
+
+        pointer operator->() const {
+            return &map_->slots_[index_];
+        }
+
+        Iterator& operator++() {
+            ++index_;
+            SkipFree();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return index_ != other.index_;
+        }
+
+    private:
+        friend class FlatHashMap;
+        template <bool>
+        friend class Iterator;
+
+        using Map = std::conditional_t<IsConst, const FlatHashMap, FlatHashMap>;
+
+        Iterator(Map* map, size_t index) : map_(map), index_(index) {}
+
+        void SkipFree() {
+            while (index_ < map_->capacity_ && map_->ctrl_[index_] < 0) {
+                ++index_;
+            }
+        }
+
+        Map* map_ = nullptr;
+        size_t index_ = 0;
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() = default;
+
+    FlatHashMap(std::initializer_list<value_type> values) {
+        reserve(values.size());
+        for (const value_type& value : values) {
+            emplace(value.first, value.second);
+        }
+    }
+
+    FlatHashMap(const FlatHashMap& other) : hasher_(other.hasher_), equal_(other.equal_) {
+        reserve(other.size());
+        for (const value_type& value : other) {
+            emplace(value.first, value.second);
+        }
+    }
+
+    FlatHashMap(FlatHashMap&& other) noexcept {
+        Swap(other);
+    }
+
+    FlatHashMap& operator=(FlatHashMap other) noexcept {
+        Swap(other);
+        return *this;
+    }
+
+    ~FlatHashMap() {
+        Destroy();
+    }
+
+    iterator begin() {
+        iterator result(this, 0);
+        result.SkipFree();
+        return result;
+    }
+
+    iterator end() {
+        return {this, capacity_};
+    }
+
+    const_iterator begin() const {
+        const_iterator result(this, 0);
+        result.SkipFree();
+        return result;
+    }
+
+    const_iterator end() const {
+        return {this, capacity_};
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    void clear() {
+        Destroy();
+    }
+
+    // Makes room for count elements without growing again
+    void reserve(size_t count) {
+        size_t capacity = GROUP_WIDTH;
+        while (count > GetMaxLoad(capacity)) {
+            capacity *= 2;
+        }
+        if (capacity > capacity_) {
+            Rehash(capacity);
+        }
+    }
+
+    iterator find(const Key& key) {
+        return {this, FindIndex(key, Mix(hasher_(key)))};
+    }
+
+    const_iterator find(const Key& key) const {
+        return {this, FindIndex(key, Mix(hasher_(key)))};
+    }
+
+    size_t count(const Key& key) const {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    Value& at(const Key& key) {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("FlatHashMap::at: no such key");
+        }
+        return it->second;
+    }
+
+    const Value& at(const Key& key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("FlatHashMap::at: no such key");
+        }
+        return it->second;
+    }
+
+    Value& operator[](const Key& key) {
+        return try_emplace(key).first->second;
+    }
+
+    // Constructs the value only if the key is absent
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        const uint64_t hash = Mix(hasher_(key));
+        size_t index = FindIndex(key, hash);
+        if (index != capacity_) {
+            return {{this, index}, false};
+        }
+
+        if (size_ + deleted_ + 1 > GetMaxLoad(capacity_)) {
+            // Deleted slots are dropped by a rehash of the same size if they take most of the load
+            Rehash(size_ + 1 > GetMaxLoad(capacity_) / 2 ? std::max(GROUP_WIDTH, capacity_ * 2) : capacity_);
+        }
+        index = FindInsertIndex(hash);
+        if (ctrl_[index] == DELETED) {
+            --deleted_;
+        }
+        new (slots_ + index) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                        std::forward_as_tuple(std::forward<Args>(args)...));
+        ctrl_[index] = GetH2(hash);
+        ++size_;
+        return {{this, index}, true};
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const Key& key, Args&&... args) {
+        return try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool> insert(value_type value) {
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    size_t erase(const Key& key) {
+        const size_t index = FindIndex(key, Mix(hasher_(key)));
+        if (index == capacity_) {
+            return 0;
+        }
+        slots_[index].~value_type();
+        ctrl_[index] = DELETED;
+        --size_;
+        ++deleted_;
+        return 1;
+    }
+
+private:
+    static size_t GetMaxLoad(size_t capacity) {
+        return capacity - capacity / 8;
+    }
+
+    static int8_t GetH2(uint64_t hash) {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    size_t GetGroupsMask() const {
+        return capacity_ / GROUP_WIDTH - 1;
+    }
+
+    // Groups are probed quadratically, which visits all of them as their number is a power of two.
+    // Returns capacity_ if there is no such key.
+    size_t FindIndex(const Key& key, uint64_t hash) const {
+        if (capacity_ == 0) {
+            return capacity_;
+        }
+        const int8_t h2 = GetH2(hash);
+        const size_t groups_mask = GetGroupsMask();
+        size_t group = (hash >> 7) & groups_mask;
+        for (size_t step = 1; ; ++step) {
+            const Group ctrl(ctrl_.get() + group * GROUP_WIDTH);
+            for (uint32_t mask = ctrl.Match(h2); mask != 0; mask &= mask - 1) {
+                const size_t index = group * GROUP_WIDTH + GetLowestBit(mask);
+                if (equal_(slots_[index].first, key)) {
+                    return index;
+                }
+            }
+            // An empty slot would have taken the key if it were further
+            if (ctrl.MatchEmpty() != 0) {
+                return capacity_;
+            }
+            group = (group + step) & groups_mask;
+        }
+    }
+
+    // The load limit keeps an empty slot in some group, so the probing ends
+    size_t FindInsertIndex(uint64_t hash) const {
+        const size_t groups_mask = GetGroupsMask();
+        size_t group = (hash >> 7) & groups_mask;
+        for (size_t step = 1; ; ++step) {
+            if (uint32_t mask = Group(ctrl_.get() + group * GROUP_WIDTH).MatchEmptyOrDeleted()) {
+                return group * GROUP_WIDTH + GetLowestBit(mask);
+            }
+            group = (group + step) & groups_mask;
+        }
+    }
+
+    void Rehash(size_t capacity) {
+        if (capacity > std::numeric_limits<size_t>::max() / sizeof(value_type)) {
+            throw std::length_error("FlatHashMap::Rehash: too many elements");
+        }
+        std::unique_ptr<int8_t[]> old_ctrl = std::move(ctrl_);
+        value_type* old_slots = slots_;
+        const size_t old_capacity = capacity_;
+
+        ctrl_ = std::make_unique<int8_t[]>(capacity);
+        std::fill_n(ctrl_.get(), capacity, EMPTY);
+        slots_ = std::allocator<value_type>().allocate(capacity);
+        capacity_ = capacity;
+        deleted_ = 0;
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                const uint64_t hash = Mix(hasher_(old_slots[i].first));
+                const size_t index = FindInsertIndex(hash);
+                new (slots_ + index) value_type(std::move(old_slots[i]));
+                ctrl_[index] = GetH2(hash);
+                old_slots[i].~value_type();
+            }
+        }
+        if (old_slots != nullptr) {
+            std::allocator<value_type>().deallocate(old_slots, old_capacity);
+        }
+    }
+
+    void Destroy() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                slots_[i].~value_type();
+            }
+        }
+        if (slots_ != nullptr) {
+            std::allocator<value_type>().deallocate(slots_, capacity_);
+        }
+        ctrl_.reset();
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    void Swap(FlatHashMap& other) noexcept {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(deleted_, other.deleted_);
+        std::swap(hasher_, other.hasher_);
+        std::swap(equal_, other.equal_);
+    }
+
+    std::unique_ptr<int8_t[]> ctrl_;
+    value_type* slots_ = nullptr;
+    size_t capacity_ = 0;   // zero or a power of two, at least GROUP_WIDTH
+    size_t size_ = 0;
+    size_t deleted_ = 0;
+    Hash hasher_;
+    KeyEqual equal_;
+};
+
+} // namespace container
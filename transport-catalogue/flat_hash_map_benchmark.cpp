@@ -0,0 +1,156 @@
+#include "flat_hash_map.h"
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "json_reader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Reads make_base requests from stdin and compares container::FlatHashMap with std::unordered_map
+// on the keys the catalogue and the router look up: stop names, bus names and the keys of
+// stop pairs joined by buses. Every key set is inserted, then looked up in random order
+// by present and absent keys.
+// Usage: flat_hash_map_benchmark [rounds_number] < make_base.json
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Timings {
+    double build_ms = 0;
+    double hit_ns = 0;
+    double miss_ns = 0;
+    size_t found = 0;
+};
+
+double GetNanoseconds(Clock::time_point begin, Clock::time_point end) {
+    return std::chrono::duration<double, std::nano>(end - begin).count();
+}
+
+template <typename Map, typename Key>
+Timings Measure(const std::vector<Key>& keys, const std::vector<Key>& missing, size_t rounds_number) {
+    Timings result;
+
+    const Clock::time_point build_begin = Clock::now();
+    Map map;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        map.emplace(keys[i], static_cast<uint32_t>(i));
+    }
+    result.build_ms = GetNanoseconds(build_begin, Clock::now()) / 1e6;
+
+    std::vector<Key> shuffled = keys;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+    const Clock::time_point hit_begin = Clock::now();
+    for (size_t round = 0; round < rounds_number; ++round) {
+        for (const Key& key : shuffled) {
+            auto it = map.find(key);
+            result.found += it != map.end() ? it->second : 0;
+        }
+    }
+    result.hit_ns = GetNanoseconds(hit_begin, Clock::now()) / static_cast<double>(rounds_number * keys.size());
+
+    const Clock::time_point miss_begin = Clock::now();
+    for (size_t round = 0; round < rounds_number; ++round) {
+        for (const Key& key : missing) {
+            result.found += map.count(key);
+        }
+    }
+    result.miss_ns = GetNanoseconds(miss_begin, Clock::now()) / static_cast<double>(rounds_number * missing.size());
+
+    return result;
+}
+
+template <typename Key, typename Hash = std::hash<Key>>
+void Compare(const std::string& name, const std::vector<Key>& keys, const std::vector<Key>& missing,
+             size_t rounds_number) {
+    if (keys.empty() || missing.empty()) {
+        return;
+    }
+    const Timings flat = Measure<container::FlatHashMap<Key, uint32_t, Hash>>(keys, missing, rounds_number);
+    const Timings node = Measure<std::unordered_map<Key, uint32_t, Hash>>(keys, missing, rounds_number);
+
+    std::cout << name << ": " << keys.size() << " keys\n" << std::fixed << std::setprecision(2)
+              << "  FlatHashMap:        build " << flat.build_ms << " ms, hit " << flat.hit_ns
+              << " ns, miss " << flat.miss_ns << " ns\n"
+              << "  std::unordered_map: build " << node.build_ms << " ms, hit " << node.hit_ns
+              << " ns, miss " << node.miss_ns << " ns\n";
+    if (flat.found != node.found) {
+        std::cout << "  MISMATCH: " << flat.found << " vs " << node.found << '\n';
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t rounds_number = argc > 1 ? std::stoul(argv[1]) : 100;
+
+    stream_input_json::JSONReader reader(std::cin);
+    reader.Read();
+
+    TransportCatalogue catalogue;
+    request_handler::BaseRequestHandler base_handler(catalogue);
+    base_handler.ProcessBaseRequests(reader);
+
+    // Absent names share long prefixes with present ones, as typos in requests do
+    std::vector<std::string> missing_storage;
+    std::vector<std::string_view> stop_names;
+    std::vector<std::string_view> missing_stop_names;
+    const std::vector<const domain::Stop*> stops = catalogue.GetAllStops();
+    missing_storage.reserve(stops.size() + catalogue.GetAllBuses().size());
+    for (const domain::Stop* stop : stops) {
+        stop_names.push_back(stop->name);
+        missing_stop_names.push_back(missing_storage.emplace_back(std::string(stop->name) + "?"));
+    }
+
+    std::vector<std::string_view> bus_names;
+    std::vector<std::string_view> missing_bus_names;
+    for (const domain::Bus* bus : catalogue.GetAllBuses()) {
+        bus_names.push_back(bus->name);
+        missing_bus_names.push_back(missing_storage.emplace_back(std::string(bus->name) + "?"));
+    }
+
+    // Keys of stop pairs the way the router numbers them, from * stops_count + to
+    std::unordered_map<std::string_view, size_t> stop_indexes;
+    for (size_t i = 0; i < stop_names.size(); ++i) {
+        stop_indexes.emplace(stop_names[i], i);
+    }
+    std::vector<size_t> pair_keys;
+    std::vector<size_t> missing_pair_keys;
+    for (const domain::Bus* bus : catalogue.GetAllBuses()) {
+        const domain::RouteView<domain::Stop*> stops = bus->GetRoute();
+        for (size_t from = 0; from < stops.size(); ++from) {
+            for (size_t to = from + 1; to < stops.size(); ++to) {
+                const size_t from_index = stop_indexes.at(stops[from]->name);
+                const size_t to_index = stop_indexes.at(stops[to]->name);
+                pair_keys.push_back(from_index * stop_names.size() + to_index);
+            }
+        }
+    }
+    std::sort(pair_keys.begin(), pair_keys.end());
+    pair_keys.erase(std::unique(pair_keys.begin(), pair_keys.end()), pair_keys.end());
+    const size_t pairs_count = stop_names.size() * stop_names.size();
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<size_t> all_pairs(0, pairs_count == 0 ? 0 : pairs_count - 1);
+    for (size_t i = 0; i < pair_keys.size() && pair_keys.size() < pairs_count; ++i) {
+        size_t key = all_pairs(generator);
+        while (std::binary_search(pair_keys.begin(), pair_keys.end(), key)) {
+            key = all_pairs(generator);
+        }
+        missing_pair_keys.push_back(key);
+    }
+
+    Compare("Stop names", stop_names, missing_stop_names, rounds_number);
+    Compare("Bus names", bus_names, missing_bus_names, rounds_number);
+    Compare("Stop pairs", pair_keys, missing_pair_keys, rounds_number);
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Checks stay on in release builds
+#undef NDEBUG
+
+#include "unit_tests.h"
+#include "flat_hash_map.h"
+
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace tests {
+
+namespace {
+
+// Few distinct hashes, so keys share groups and probe past each other
+struct CollidingHasher {
+    size_t operator()(int key) const {
+        return static_cast<size_t>(key % 5);
+    }
+};
+
+template <typename Map, typename Expected>
+void CheckSame(const Map& map, const Expected& expected) {
+    assert(map.size() == expected.size());
+    assert(map.empty() == expected.empty());
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+        assert(expected.at(key) == value);
+        ++visited;
+    }
+    assert(visited == expected.size());
+    for (const auto& [key, value] : expected) {
+        assert(map.count(key) == 1);
+        assert(map.at(key) == value);
+    }
+}
+
+// Random inserts and erases over a small key range, so erased slots are reused and
+// rehashes in place drop them
+template <typename Hasher>
+void TestRandomOperations(uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> keys(0, 300);
+    std::uniform_int_distribution<int> operations(0, 3);
+
+    container::FlatHashMap<int, int, Hasher> map;
+    std::unordered_map<int, int> expected;
+    for (int i = 0; i < 20000; ++i) {
+        const int key = keys(generator);
+        switch (operations(generator)) {
+        case 0:
+            map[key] = i;
+            expected[key] = i;
+            break;
+        case 1: {
+            const bool inserted = map.emplace(key, i).second;
+            assert(inserted == expected.emplace(key, i).second);
+            break;
+        }
+        case 2:
+            assert(map.erase(key) == expected.erase(key));
+            break;
+        default:
+            assert((map.find(key) == map.end()) == (expected.count(key) == 0));
+        }
+        if (i % 1000 == 0) {
+            CheckSame(map, expected);
+        }
+    }
+    CheckSame(map, expected);
+}
+
+void TestGrowth() {
+    container::FlatHashMap<int, int> map;
+    assert(map.find(1) == map.end());
+    assert(map.erase(1) == 0);
+
+    std::unordered_map<int, int> expected;
+    for (int i = 0; i < 100000; ++i) {
+        map[i * 7919] = i;
+        expected[i * 7919] = i;
+    }
+    CheckSame(map, expected);
+
+    for (int i = 0; i < 100000; i += 2) {
+        assert(map.erase(i * 7919) == 1);
+        expected.erase(i * 7919);
+    }
+    CheckSame(map, expected);
+
+    map.clear();
+    assert(map.empty() && map.begin() == map.end());
+    map.reserve(1000);
+    map[5] = 6;
+    assert(map.size() == 1 && map.at(5) == 6);
+}
+
+void TestOwningValues() {
+    container::FlatHashMap<std::string, std::string> map;
+    for (int i = 0; i < 1000; ++i) {
+        map[std::to_string(i)] = std::string(100, static_cast<char>('a' + i % 26));
+    }
+    for (int i = 0; i < 1000; i += 3) {
+        map.erase(std::to_string(i));
+    }
+
+    const container::FlatHashMap<std::string, std::string> copy(map);
+    container::FlatHashMap<std::string, std::string> moved(std::move(map));
+    assert(map.empty());
+    assert(copy.size() == moved.size());
+    for (const auto& [key, value] : copy) {
+        assert(moved.at(key) == value);
+    }
+
+    map = copy;
+    map["extra"] = "value";
+    assert(map.size() == copy.size() + 1 && copy.count("extra") == 0);
+}
+
+// Mutable iterators of a map convert to const ones and compare with them
+void TestIteratorConversion() {
+    using Map = container::FlatHashMap<int, int>;
+    Map map{{1, 10}, {2, 20}, {3, 30}};
+
+    Map::const_iterator it = map.begin();
+    const Map::const_iterator end = map.end();
+    int sum = 0;
+    for (; it != end; ++it) {
+        sum += it->second;
+    }
+    assert(sum == 60);
+
+    Map::iterator found = map.find(2);
+    Map::const_iterator const_found = found;
+    assert(const_found == found && const_found->first == 2);
+    found->second = 25;
+    assert(const_found->second == 25);
+
+    const Map& const_map = map;
+    assert(const_map.find(2) == Map::const_iterator(map.find(2)));
+    assert(const_map.find(4) == Map::const_iterator(map.end()));
+}
+
+} //namespace
+
+void TestFlatHashMap() {
+    for (uint32_t seed = 0; seed < 4; ++seed) {
+        TestRandomOperations<std::hash<int>>(seed);
+        TestRandomOperations<CollidingHasher>(seed);
+    }
+    TestGrowth();
+    TestOwningValues();
+    TestIteratorConversion();
+}
+
+} //namespace tests
@@ -1,11 +1,19 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace geo{
 
 const int EARTH_RADIUS = 6371000;
 
+inline const double DEG_TO_RAD = 3.1415926535 / 180.;
+
 struct Coordinates {
     double lat;
     double lng;
@@ -22,9 +30,82 @@ inline double ComputeDistance(Coordinates from, Coordinates to) {
     if (from == to) {
         return 0;
     }
-    static const double dr = 3.1415926535 / 180.;
+    const double dr = DEG_TO_RAD;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
         * EARTH_RADIUS;
 }
+
+// Points with sines and cosines of their latitudes computed once, in separate arrays.
+// Distances between them are equal to ComputeDistance() ones bit for bit: the cosine of
+// the longitude difference is still computed per pair, as splitting it changes rounding.
+class PointsTrig {
+public:
+    size_t AddPoint(Coordinates point) {
+        lat_.push_back(0);
+        lng_.push_back(0);
+        sin_lat_.push_back(0);
+        cos_lat_.push_back(0);
+        SetPoint(lat_.size() - 1, point);
+        return lat_.size() - 1;
+    }
+
+    void SetPoint(size_t index, Coordinates point) {
+        lat_[index] = point.lat;
+        lng_[index] = point.lng;
+        sin_lat_[index] = std::sin(point.lat * DEG_TO_RAD);
+        cos_lat_[index] = std::cos(point.lat * DEG_TO_RAD);
+    }
+
+    size_t GetSize() const {
+        return lat_.size();
+    }
+
+    double ComputeDistance(size_t from, size_t to) const {
+        if (lat_[from] == lat_[to] && lng_[from] == lng_[to]) {
+            return 0;
+        }
+        return std::acos(sin_lat_[from] * sin_lat_[to]
+                         + cos_lat_[from] * cos_lat_[to] * std::cos(std::abs(lng_[from] - lng_[to]) * DEG_TO_RAD))
+            * EARTH_RADIUS;
+    }
+
+    // result[i] is the distance from point from[i] to point to[i]. Library calls go one
+    // by one, arithmetic between them takes two pairs per SSE2 instruction.
+    void ComputeDistances(const uint32_t* from, const uint32_t* to, size_t count, double* result) const {
+        for (size_t i = 0; i < count; ++i) {
+            result[i] = std::cos(std::abs(lng_[from[i]] - lng_[to[i]]) * DEG_TO_RAD);
+        }
+
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 2 <= count; i += 2) {
+            const __m128d sin_from = _mm_set_pd(sin_lat_[from[i + 1]], sin_lat_[from[i]]);
+            const __m128d sin_to = _mm_set_pd(sin_lat_[to[i + 1]], sin_lat_[to[i]]);
+            const __m128d cos_from = _mm_set_pd(cos_lat_[from[i + 1]], cos_lat_[from[i]]);
+            const __m128d cos_to = _mm_set_pd(cos_lat_[to[i + 1]], cos_lat_[to[i]]);
+            const __m128d cos_lng = _mm_loadu_pd(result + i);
+            _mm_storeu_pd(result + i, _mm_add_pd(_mm_mul_pd(sin_from, sin_to),
+                                                 _mm_mul_pd(_mm_mul_pd(cos_from, cos_to), cos_lng)));
+        }
+#endif
+        for (; i < count; ++i) {
+            result[i] = sin_lat_[from[i]] * sin_lat_[to[i]] + cos_lat_[from[i]] * cos_lat_[to[i]] * result[i];
+        }
+
+        for (i = 0; i < count; ++i) {
+            if (lat_[from[i]] == lat_[to[i]] && lng_[from[i]] == lng_[to[i]]) {
+                result[i] = 0;
+            } else {
+                result[i] = std::acos(result[i]) * EARTH_RADIUS;
+            }
+        }
+    }
+
+private:
+    std::vector<double> lat_;
+    std::vector<double> lng_;
+    std::vector<double> sin_lat_;
+    std::vector<double> cos_lat_;
+};
 } //namespace geo
@@ -0,0 +1,334 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Hub labeling: every vertex keeps a forward label of hubs it reaches and a backward label
+// of hubs reaching it, with distances. Labels are built by pruned Dijkstra searches from
+// vertexes in order of importance, so every shortest path has a common hub of both ends,
+// and a distance query is a linear merge of two labels sorted by hub rank. Every label entry
+// also keeps the next edge towards its hub, which unpacks a route hub by hub.
+template <typename Weight>
+class HubLabels {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    // Labels of all vertexes, entries of vertex v are [begins[v], begins[v + 1]), sorted by hub rank
+    struct Labels {
+        std::vector<uint32_t> begins;
+        std::vector<uint32_t> hubs;
+        std::vector<Weight> weights;
+        // Forward labels: first edge of the path to the hub, backward ones: last edge of the path
+        // from the hub, NO_EDGE in the entry of the vertex itself
+        std::vector<uint32_t> edges;
+
+        size_t GetSize(VertexId vertex) const {
+            return begins[vertex + 1] - begins[vertex];
+        }
+    };
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    HubLabels() = default;
+
+    explicit HubLabels(const Graph& graph);
+
+    // Labels read from a base, order maps hub ranks to vertexes
+    HubLabels(std::vector<VertexId> order, Labels forward, Labels backward);
+
+    const std::vector<VertexId>& GetOrder() const {
+        return order_;
+    }
+
+    const Labels& GetForwardLabels() const {
+        return forward_;
+    }
+
+    const Labels& GetBackwardLabels() const {
+        return backward_;
+    }
+
+    size_t GetVertexCount() const {
+        return order_.size();
+    }
+
+    std::optional<Weight> GetWeight(VertexId from, VertexId to) const;
+
+    // The graph should be the one labels were built for
+    std::optional<RouteInfo> BuildRoute(const Graph& graph, VertexId from, VertexId to) const;
+
+private:
+    struct Entry {
+        uint32_t hub;
+        Weight weight;
+        uint32_t edge;
+    };
+    using RawLabels = std::vector<std::vector<Entry>>;
+
+    struct CommonHub {
+        uint32_t hub;
+        Weight weight;
+    };
+
+    std::optional<CommonHub> FindCommonHub(VertexId from, VertexId to) const;
+
+    // Entry of the hub in the label of the vertex, the hub must be there
+    static size_t FindEntry(const Labels& labels, VertexId vertex, uint32_t hub);
+
+    // Pruned Dijkstra search from the hub of this rank adding entries to found_labels, over the
+    // reversed graph for forward labels. Vertexes whose distance is already covered are pruned.
+    static void AddHub(const Graph& graph, uint32_t rank, VertexId source, const RawLabels& source_labels,
+                       RawLabels& found_labels, std::vector<Weight>& hub_weights);
+
+    static Labels Compact(RawLabels raw_labels);
+
+    void CheckSizes() const;
+
+    std::vector<VertexId> order_;
+    Labels forward_;
+    Labels backward_;
+};
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+
+    Graph reversed(vertex_count);
+    std::vector<size_t> degrees(vertex_count, 0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const Edge<Weight>& edge = graph.GetEdge(edge_id);
+        reversed.AddEdge({edge.to, edge.from, edge.weight});
+        ++degrees[edge.from];
+        ++degrees[edge.to];
+    }
+
+    // Vertexes with more edges lie on more shortest paths, so they go first
+    order_.resize(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        order_[vertex] = vertex;
+    }
+    std::stable_sort(order_.begin(), order_.end(), [&degrees](VertexId lhs, VertexId rhs) {
+        return degrees[lhs] > degrees[rhs];
+    });
+
+    RawLabels forward(vertex_count);
+    RawLabels backward(vertex_count);
+    std::vector<Weight> hub_weights(vertex_count, std::numeric_limits<Weight>::max());
+
+    for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+        const VertexId source = order_[rank];
+        AddHub(graph, rank, source, forward, backward, hub_weights);
+        AddHub(reversed, rank, source, backward, forward, hub_weights);
+    }
+
+    forward_ = Compact(std::move(forward));
+    backward_ = Compact(std::move(backward));
+}
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(std::vector<VertexId> order, Labels forward, Labels backward)
+    : order_(std::move(order))
+    , forward_(std::move(forward))
+    , backward_(std::move(backward))
+{
+    CheckSizes();
+}
+
+template <typename Weight>
+void HubLabels<Weight>::CheckSizes() const {
+    for (const Labels* labels : {&forward_, &backward_}) {
+        const size_t size = labels->hubs.size();
+        if (labels->begins.size() != order_.size() + 1 || labels->begins.back() != size
+            || labels->weights.size() != size || labels->edges.size() != size)
+        {
+            throw std::invalid_argument("HubLabels: labels don't match vertexes number");
+        }
+        for (uint32_t hub : labels->hubs) {
+            if (hub >= order_.size()) {
+                throw std::invalid_argument("HubLabels: hub rank is out of range");
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void HubLabels<Weight>::AddHub(const Graph& graph, uint32_t rank, VertexId source,
+                               const RawLabels& source_labels, RawLabels& found_labels,
+                               std::vector<Weight>& hub_weights) {
+    // Distances between the source and hubs of higher ranks, to check the coverage in O(label)
+    for (const Entry& entry : source_labels[source]) {
+        hub_weights[entry.hub] = entry.weight;
+    }
+
+    struct VertexData {
+        Weight weight;
+        uint32_t edge;
+    };
+    std::vector<std::optional<VertexData>> vertexes_data(graph.GetVertexCount());
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    vertexes_data[source] = VertexData{Weight{}, NO_EDGE};
+    queue.push({Weight{}, source});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (vertexes_data[vertex]->weight < weight) {
+            continue;
+        }
+
+        bool is_covered = false;
+        for (const Entry& entry : found_labels[vertex]) {
+            if (hub_weights[entry.hub] != std::numeric_limits<Weight>::max()
+                && !(weight < hub_weights[entry.hub] + entry.weight))
+            {
+                is_covered = true;
+                break;
+            }
+        }
+        if (is_covered) {
+            continue;
+        }
+        found_labels[vertex].push_back({rank, weight, vertexes_data[vertex]->edge});
+
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < Weight{}) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            auto& vertex_data = vertexes_data[edge.to];
+            if (!vertex_data || candidate_weight < vertex_data->weight) {
+                // Reversed graph keeps edge ids of the original one
+                vertex_data = VertexData{candidate_weight, static_cast<uint32_t>(edge_id)};
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+
+    for (const Entry& entry : source_labels[source]) {
+        hub_weights[entry.hub] = std::numeric_limits<Weight>::max();
+    }
+}
+
+template <typename Weight>
+typename HubLabels<Weight>::Labels HubLabels<Weight>::Compact(RawLabels raw_labels) {
+    Labels result;
+    result.begins.reserve(raw_labels.size() + 1);
+    result.begins.push_back(0);
+
+    size_t size = 0;
+    for (const std::vector<Entry>& label : raw_labels) {
+        size += label.size();
+    }
+    result.hubs.reserve(size);
+    result.weights.reserve(size);
+    result.edges.reserve(size);
+
+    for (std::vector<Entry>& label : raw_labels) {
+        for (const Entry& entry : label) {
+            result.hubs.push_back(entry.hub);
+            result.weights.push_back(entry.weight);
+            result.edges.push_back(entry.edge);
+        }
+        result.begins.push_back(result.hubs.size());
+        label = {};
+    }
+    return result;
+}
+
+template <typename Weight>
+std::optional<typename HubLabels<Weight>::CommonHub>
+HubLabels<Weight>::FindCommonHub(VertexId from, VertexId to) const {
+    std::optional<CommonHub> result;
+
+    size_t i = forward_.begins.at(from);
+    const size_t forward_end = forward_.begins[from + 1];
+    size_t j = backward_.begins.at(to);
+    const size_t backward_end = backward_.begins[to + 1];
+
+    while (i < forward_end && j < backward_end) {
+        const uint32_t forward_hub = forward_.hubs[i];
+        const uint32_t backward_hub = backward_.hubs[j];
+        if (forward_hub < backward_hub) {
+            ++i;
+        } else if (backward_hub < forward_hub) {
+            ++j;
+        } else {
+            const Weight weight = forward_.weights[i] + backward_.weights[j];
+            if (!result || weight < result->weight) {
+                result = CommonHub{forward_hub, weight};
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+size_t HubLabels<Weight>::FindEntry(const Labels& labels, VertexId vertex, uint32_t hub) {
+    const auto begin = labels.hubs.begin() + labels.begins[vertex];
+    const auto end = labels.hubs.begin() + labels.begins[vertex + 1];
+    const auto it = std::lower_bound(begin, end, hub);
+    if (it == end || *it != hub) {
+        throw std::logic_error("HubLabels: broken route through a hub");
+    }
+    return it - labels.hubs.begin();
+}
+
+template <typename Weight>
+std::optional<Weight> HubLabels<Weight>::GetWeight(VertexId from, VertexId to) const {
+    if (std::optional<CommonHub> hub = FindCommonHub(from, to)) {
+        return hub->weight;
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+std::optional<typename HubLabels<Weight>::RouteInfo>
+HubLabels<Weight>::BuildRoute(const Graph& graph, VertexId from, VertexId to) const {
+    const std::optional<CommonHub> hub = FindCommonHub(from, to);
+    if (!hub) {
+        return std::nullopt;
+    }
+    const VertexId hub_vertex = order_[hub->hub];
+
+    std::vector<EdgeId> edges;
+    for (VertexId vertex = from; vertex != hub_vertex; ) {
+        const EdgeId edge_id = forward_.edges[FindEntry(forward_, vertex, hub->hub)];
+        edges.push_back(edge_id);
+        vertex = graph.GetEdge(edge_id).to;
+    }
+
+    const size_t middle = edges.size();
+    for (VertexId vertex = to; vertex != hub_vertex; ) {
+        const EdgeId edge_id = backward_.edges[FindEntry(backward_, vertex, hub->hub)];
+        edges.push_back(edge_id);
+        vertex = graph.GetEdge(edge_id).from;
+    }
+    std::reverse(edges.begin() + middle, edges.end());
+
+    return RouteInfo{hub->weight, std::move(edges)};
+}
+
+}  // namespace graph
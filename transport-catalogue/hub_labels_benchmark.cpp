@@ -0,0 +1,123 @@
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include "json_reader.h"
+#include "hub_labels.h"
+#include "shortest_paths.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Reads make_base requests from stdin, builds hub labels of their routing graph and reports
+// label sizes and query times against Dijkstra's algorithm for random stop pairs.
+// Usage: hub_labels_benchmark [queries_number] < make_base.json
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double GetMicroseconds(Clock::time_point begin, Clock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - begin).count();
+}
+
+void PrintLabelsStats(std::string_view name, const graph::HubLabels<double>::Labels& labels, size_t vertex_count) {
+    size_t max_size = 0;
+    for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        max_size = std::max(max_size, labels.GetSize(vertex));
+    }
+    std::cout << name << " labels: " << labels.hubs.size() << " entries, "
+              << static_cast<double>(labels.hubs.size()) / std::max<size_t>(1, vertex_count) << " per vertex, "
+              << max_size << " at most\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t queries_number = argc > 1 ? std::stoul(argv[1]) : 10000;
+
+    stream_input_json::JSONReader reader(std::cin);
+    reader.Read();
+
+    TransportCatalogue catalogue;
+    request_handler::BaseRequestHandler base_handler(catalogue);
+    base_handler.ProcessBaseRequests(reader);
+
+    request_handler::RoutingSettings settings = reader.GetRoutingSettings();
+    settings.landmarks_count.reset();
+    settings.hub_labels = false;
+
+    request_handler::DistanceComputer distance_computer(catalogue);
+    request_handler::MapData map_data{catalogue.GetStopsUsed(), catalogue.GetBusesForRender()};
+    transport_router::TransportRouter router(settings, distance_computer, map_data);
+    const graph::DirectedWeightedGraph<double>& graph = router.GetSerializationData().graph;
+    const size_t vertex_count = graph.GetVertexCount();
+    if (vertex_count == 0) {
+        std::cout << "Routing graph is empty\n";
+        return 0;
+    }
+
+    const Clock::time_point build_begin = Clock::now();
+    const graph::HubLabels<double> hub_labels(graph);
+    const Clock::time_point build_end = Clock::now();
+
+    std::cout << "Routing graph: " << vertex_count << " vertexes, " << graph.GetEdgeCount() << " edges\n";
+    std::cout << "Labels built in " << GetMicroseconds(build_begin, build_end) / 1000 << " ms\n";
+    PrintLabelsStats("Forward", hub_labels.GetForwardLabels(), vertex_count);
+    PrintLabelsStats("Backward", hub_labels.GetBackwardLabels(), vertex_count);
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<graph::VertexId> vertexes(0, vertex_count - 1);
+    std::vector<std::pair<graph::VertexId, graph::VertexId>> queries(queries_number);
+    for (auto& [from, to] : queries) {
+        from = vertexes(generator);
+        to = vertexes(generator);
+    }
+
+    // Sums keep the optimizer from dropping the queries
+    double weights_sum = 0;
+    size_t edges_sum = 0;
+
+    const Clock::time_point weights_begin = Clock::now();
+    for (const auto& [from, to] : queries) {
+        weights_sum += hub_labels.GetWeight(from, to).value_or(0);
+    }
+    const Clock::time_point routes_begin = Clock::now();
+    for (const auto& [from, to] : queries) {
+        if (auto route = hub_labels.BuildRoute(graph, from, to)) {
+            edges_sum += route->edges.size();
+        }
+    }
+    const Clock::time_point routes_end = Clock::now();
+
+    // Dijkstra's algorithm is slow, so it checks and times only a part of the queries
+    const size_t checked_number = std::min<size_t>(queries_number, 1000);
+    size_t mismatches = 0;
+    const Clock::time_point dijkstra_begin = Clock::now();
+    for (size_t i = 0; i < checked_number; ++i) {
+        const auto [from, to] = queries[i];
+        const std::optional<double> expected = graph::ShortestPathsTree<double>(graph, from).GetWeight(to);
+        const std::optional<double> found = hub_labels.GetWeight(from, to);
+        if (expected.has_value() != found.has_value()
+            || (expected && std::abs(*expected - *found) > 1e-9 * std::max(1.0, *expected)))
+        {
+            ++mismatches;
+        }
+    }
+    const Clock::time_point dijkstra_end = Clock::now();
+
+    const double queries_count = std::max<size_t>(1, queries_number);
+    std::cout << "Distance query: " << GetMicroseconds(weights_begin, routes_begin) / queries_count << " us\n";
+    std::cout << "Route query with unpacking: " << GetMicroseconds(routes_begin, routes_end) / queries_count << " us\n";
+    std::cout << "Dijkstra query: " << GetMicroseconds(dijkstra_begin, dijkstra_end) / std::max<size_t>(1, checked_number)
+              << " us\n";
+    std::cout << "Mismatches with Dijkstra: " << mismatches << " of " << checked_number << "\n";
+    std::cout << "Checksums: " << weights_sum << " " << edges_sum << "\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
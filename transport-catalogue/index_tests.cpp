@@ -0,0 +1,226 @@
+// Checks stay on in release builds
+#undef NDEBUG
+
+#include "unit_tests.h"
+#include "dynamic_bitset.h"
+#include "spatial_index.h"
+#include "geo.h"
+#include "name_index.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <limits>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tests {
+
+namespace {
+
+std::vector<size_t> GetSetBits(const container::DynamicBitset& bitset) {
+    std::vector<size_t> result;
+    bitset.ForEachSet([&result](size_t index) {
+        result.push_back(index);
+    });
+    return result;
+}
+
+// Sets of different sizes, so words of one are past the end of the other
+void TestBitsetAgainstSets() {
+    std::mt19937 generator(5);
+    for (size_t size : {1, 63, 64, 65, 130, 1000}) {
+        std::uniform_int_distribution<size_t> indexes(0, size - 1);
+        container::DynamicBitset lhs;
+        container::DynamicBitset rhs;
+        std::set<size_t> lhs_expected;
+        std::set<size_t> rhs_expected;
+        assert(lhs.None() && lhs.Count() == 0);
+        for (size_t i = 0; i < size / 2 + 1; ++i) {
+            const size_t lhs_index = indexes(generator);
+            const size_t rhs_index = indexes(generator) / 2;
+            lhs.Set(lhs_index);
+            rhs.Set(rhs_index);
+            lhs_expected.insert(lhs_index);
+            rhs_expected.insert(rhs_index);
+        }
+
+        assert(lhs.Count() == lhs_expected.size() && !lhs.None());
+        assert(GetSetBits(lhs) == std::vector<size_t>(lhs_expected.begin(), lhs_expected.end()));
+        for (size_t index = 0; index < size + 70; ++index) {
+            assert(lhs.Test(index) == (lhs_expected.count(index) == 1));
+        }
+
+        std::vector<size_t> both;
+        for (size_t index : lhs_expected) {
+            if (rhs_expected.count(index) == 1) {
+                both.push_back(index);
+            }
+        }
+        assert(GetSetBits(container::DynamicBitset::Intersect(lhs, rhs)) == both);
+        assert(GetSetBits(container::DynamicBitset::Intersect(rhs, lhs)) == both);
+    }
+}
+
+// Points are clustered, some coincide, so cells are uneven and distances tie
+void TestGridAgainstBruteForce() {
+    std::mt19937 generator(6);
+    std::uniform_real_distribution<double> offsets(0, 0.02);
+    std::vector<geo::Coordinates> points;
+    for (size_t i = 0; i < 300; ++i) {
+        const double cluster = i % 3 == 0 ? 0.2 : 0;
+        points.push_back({55.6 + cluster + offsets(generator), 37.5 + cluster + offsets(generator)});
+    }
+    for (size_t i = 0; i < 20; ++i) {
+        points.push_back(points[i * 7]);
+    }
+    const geo::GridIndex index(points);
+    assert(index.GetSize() == points.size());
+
+    std::uniform_real_distribution<double> centers(-0.05, 0.3);
+    for (int query = 0; query < 100; ++query) {
+        geo::Coordinates center = points[query];
+        if (query % 10 != 0) {
+            center = {55.6 + centers(generator), 37.5 + centers(generator)};
+        }
+        std::vector<geo::GridIndex::Neighbour> expected;
+        for (size_t i = 0; i < points.size(); ++i) {
+            expected.push_back({i, geo::ComputeDistance(center, points[i])});
+        }
+        std::sort(expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.index < rhs.index);
+        });
+
+        for (size_t count : {1, 5, 50, 1000}) {
+            const double max_distance = query % 2 == 0 ? std::numeric_limits<double>::infinity() : 3000;
+            std::vector<geo::GridIndex::Neighbour> found = index.FindNearest(center, count, max_distance);
+            size_t expected_size = 0;
+            while (expected_size < std::min(count, expected.size())
+                   && expected[expected_size].distance <= max_distance) {
+                ++expected_size;
+            }
+            assert(found.size() == expected_size);
+            for (size_t i = 0; i < found.size(); ++i) {
+                assert(found[i].index == expected[i].index);
+                assert(std::abs(found[i].distance - expected[i].distance) <= 1e-6);
+            }
+        }
+    }
+
+    assert(geo::GridIndex(std::vector<geo::Coordinates>{}).FindNearest({55.6, 37.5}, 10).empty());
+}
+
+void TestNameIndex() {
+    const std::vector<std::string> storage{"b", "ab", "a", "abc", "b", "", "abd", "ab", "c"};
+    const std::vector<std::string_view> names(storage.begin(), storage.end());
+    const domain::NameIndex index(names);
+
+    // Equal names go by position
+    const std::vector<uint32_t> expected_order{5, 2, 1, 7, 3, 6, 0, 4, 8};
+    assert(index.GetOrder() == expected_order);
+
+    for (std::string_view prefix : {"", "a", "ab", "abc", "b", "z", "abcd"}) {
+        for (size_t count : {0, 1, 2, 100}) {
+            std::vector<std::string_view> expected;
+            for (uint32_t position : expected_order) {
+                if (expected.size() < count && names[position].substr(0, prefix.size()) == prefix
+                    && (expected.empty() || expected.back() != names[position])) {
+                    expected.push_back(names[position]);
+                }
+            }
+            assert(index.FindByPrefix(prefix, count) == expected);
+        }
+    }
+
+    // Orders read from a base are taken only if they are the sorted one
+    assert(domain::NameIndex(names, expected_order).GetOrder() == expected_order);
+    std::vector<uint32_t> swapped_equal = expected_order;
+    std::swap(swapped_equal[2], swapped_equal[3]);
+    assert(domain::NameIndex(names, swapped_equal).GetOrder() == expected_order);
+    assert(domain::NameIndex(names, {0, 1, 2}).GetOrder() == expected_order);
+    std::vector<uint32_t> repeated = expected_order;
+    repeated[0] = repeated[1];
+    assert(domain::NameIndex(names, repeated).GetOrder() == expected_order);
+}
+
+// Of buses sharing a name the first added is rendered
+void TestBusesForRenderKeepFirst() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop({"A", {55.6, 37.5}, {{"B", 100}}});
+    catalogue.AddStop({"B", {55.61, 37.5}, {{"C", 100}}});
+    catalogue.AddStop({"C", {55.62, 37.5}, {}});
+    catalogue.AddBus({"1", {"A", "B"}, false});
+    catalogue.AddBus({"0", {"A"}, false});
+    catalogue.AddBus({"1", {"B", "C"}, false});
+
+    const domain::BusesForRender buses = catalogue.GetBusesForRender();
+    std::vector<const domain::Bus*> rendered(buses.begin(), buses.end());
+    assert(rendered.size() == 2);
+    assert(rendered[0]->name == "0");
+    assert(rendered[1]->name == "1" && rendered[1]->stops.front()->name == "A");
+}
+
+// Memoized Bus answers follow changes of distances, coordinates and buses
+void TestBusLengthsFollowChanges() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop({"A", {55.6, 37.5}, {{"B", 1000}}});
+    catalogue.AddStop({"B", {55.61, 37.5}, {{"C", 2000}}});
+    catalogue.AddStop({"C", {55.62, 37.5}, {}});
+    catalogue.AddBus({"1", {"A", "B", "C"}, true});
+    catalogue.AddBus({"2", {"B", "C"}, true});
+
+    assert(catalogue.GetBusInfo("1").length.real_length == 3000);
+    assert(catalogue.GetBusInfo("2").length.real_length == 2000);
+
+    catalogue.AddDistance("A", "B", 1500);
+    assert(catalogue.GetBusInfo("1").length.real_length == 3500);
+    assert(catalogue.GetBusInfo("2").length.real_length == 2000);
+
+    const double curvature = catalogue.GetBusInfo("1").length.curvature;
+    catalogue.AddStop({"C", {55.63, 37.5}, {}});
+    assert(catalogue.GetBusInfo("1").length.curvature < curvature);
+
+    catalogue.AddBus({"2", {"A", "B"}, true});
+    assert(catalogue.GetBusInfo("2").length.real_length == 1500);
+}
+
+// A bus name added twice is listed once by Stop and DirectBuses answers
+void TestBusAddedTwiceListedOnce() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop({"A", {55.6, 37.5}, {{"B", 100}}});
+    catalogue.AddStop({"B", {55.61, 37.5}, {{"C", 100}}});
+    catalogue.AddStop({"C", {55.62, 37.5}, {}});
+    catalogue.AddBus({"X", {"A", "B"}, false});
+    catalogue.AddBus({"Y", {"A", "B"}, false});
+    catalogue.AddBus({"X", {"A", "B", "C"}, false});
+
+    const std::vector<std::string_view> expected{"X", "Y"};
+    assert(catalogue.GetStopInfo("A").buses == expected);
+    assert(catalogue.GetDirectBuses("A", "B").buses == expected);
+
+    // Suggestions don't repeat the name or spend the count on it
+    const std::vector<domain::NameSuggestion> suggestions = catalogue.Suggest("", 4);
+    assert(suggestions.size() == 4);
+    assert(suggestions[0].name == "A" && suggestions[1].name == "B" && suggestions[2].name == "C");
+    assert(suggestions[3].name == "X" && suggestions[3].is_bus);
+    const std::vector<domain::NameSuggestion> buses = catalogue.Suggest("X", 5);
+    assert(buses.size() == 1 && buses[0].name == "X");
+}
+
+} //namespace
+
+void TestIndexes() {
+    TestBitsetAgainstSets();
+    TestGridAgainstBruteForce();
+    TestNameIndex();
+    TestBusesForRenderKeepFirst();
+    TestBusLengthsFollowChanges();
+    TestBusAddedTwiceListedOnce();
+}
+
+} //namespace tests
@@ -50,6 +50,52 @@ request_handler::StopInfoRequest GetStopStatRequest(const json::Dict& request) {
     return result;
 }
 
+request_handler::DirectBusesRequest GetDirectBusesStatRequest(const json::Dict& request) {
+    request_handler::DirectBusesRequest result;
+    result.id = request.at("id").AsInt();
+    result.stop_from = request.at("from").AsString();
+    result.stop_to = request.at("to").AsString();
+    return result;
+}
+
+request_handler::NearbyRequest GetNearbyStatRequest(const json::Dict& request) {
+    request_handler::NearbyRequest result;
+    result.id = request.at("id").AsInt();
+    result.center = {request.at("latitude").AsDouble(), request.at("longitude").AsDouble()};
+
+    if (auto it = request.find("count"); it != request.end()) {
+        result.count = it->second.AsInt();
+        if (*result.count < 0) {
+            throw std::invalid_argument("json_reader::GetNearbyStatRequest: count should be non-negative\n");
+        }
+    }
+    if (auto it = request.find("radius"); it != request.end()) {
+        result.radius = it->second.AsDouble();
+        if (!(*result.radius >= 0)) {
+            throw std::invalid_argument("json_reader::GetNearbyStatRequest: radius should be non-negative\n");
+        }
+    }
+    if (!result.count && !result.radius) {
+        throw std::invalid_argument("json_reader::GetNearbyStatRequest: count or radius should be set\n");
+    }
+    return result;
+}
+
+request_handler::SuggestRequest GetSuggestStatRequest(const json::Dict& request) {
+    request_handler::SuggestRequest result;
+    result.id = request.at("id").AsInt();
+    result.prefix = request.at("prefix").AsString();
+
+    if (auto it = request.find("count"); it != request.end()) {
+        const int count = it->second.AsInt();
+        if (count < 0) {
+            throw std::invalid_argument("json_reader::GetSuggestStatRequest: count should be non-negative\n");
+        }
+        result.count = static_cast<size_t>(count);
+    }
+    return result;
+}
+
 request_handler::MapInfoRequest GetMapStatRequest(const json::Dict& request) {
     request_handler::MapInfoRequest result;
     result.id = request.at("id").AsInt();
@@ -61,6 +107,29 @@ request_handler::RoutingInfoRequest GetRouteStatRequest(const json::Dict& reques
     result.id = request.at("id").AsInt();
     result.stop_from = request.at("from").AsString();
     result.stop_to = request.at("to").AsString();
+
+    if (auto it = request.find("routing_settings"); it != request.end()) {
+        const json::Dict& settings = it->second.AsDict();
+        if (auto wait_it = settings.find("bus_wait_time"); wait_it != settings.end()) {
+            result.wait_time = wait_it->second.AsInt();
+            if (*result.wait_time < 0) {
+                throw std::invalid_argument("json_reader::GetRouteStatRequest: bus_wait_time should be non-negative\n");
+            }
+        }
+        if (auto velocity_it = settings.find("bus_velocity"); velocity_it != settings.end()) {
+            result.bus_velocity = velocity_it->second.AsDouble();
+            if (!(*result.bus_velocity > 0)) {
+                throw std::invalid_argument("json_reader::GetRouteStatRequest: bus_velocity should be positive\n");
+            }
+        }
+    }
+
+    if (auto it = request.find("max_transfers"); it != request.end()) {
+        result.max_transfers = it->second.AsInt();
+        if (*result.max_transfers < 0) {
+            throw std::invalid_argument("json_reader::GetRouteStatRequest: max_transfers should be non-negative\n");
+        }
+    }
     return result;
 }
 
@@ -188,6 +257,27 @@ request_handler::RoutingSettings JSONReader::ParseRoutingSettings(const json::Di
     result.bus_velocity = request.at("bus_velocity").AsDouble();
     result.wait_time    = request.at("bus_wait_time").AsInt();
 
+    if (auto it = request.find("time_units_per_minute"); it != request.end()) {
+        result.time_units_per_minute = it->second.AsInt();
+        if (*result.time_units_per_minute <= 0) {
+            throw std::invalid_argument("JSONReader::ParseRoutingSettings: time_units_per_minute should be positive\n");
+        }
+    }
+
+    if (auto it = request.find("landmarks_count"); it != request.end()) {
+        result.landmarks_count = it->second.AsInt();
+        if (*result.landmarks_count <= 0) {
+            throw std::invalid_argument("JSONReader::ParseRoutingSettings: landmarks_count should be positive\n");
+        }
+    }
+
+    if (auto it = request.find("hub_labels"); it != request.end()) {
+        result.hub_labels = it->second.AsBool();
+        if (result.hub_labels && result.landmarks_count) {
+            throw std::invalid_argument("JSONReader::ParseRoutingSettings: landmarks and hub labels can't be used together\n");
+        }
+    }
+
     return result;
 }
 
@@ -202,6 +292,12 @@ void JSONReader::GetOneStatRequest(const json::Node& request) {
         AddStatRequest(detail::GetMapStatRequest(req_dict));
     } else if (type == "Route"){
         AddStatRequest(detail::GetRouteStatRequest(req_dict));
+    } else if (type == "DirectBuses") {
+        AddStatRequest(detail::GetDirectBusesStatRequest(req_dict));
+    } else if (type == "Nearby") {
+        AddStatRequest(detail::GetNearbyStatRequest(req_dict));
+    } else if (type == "Suggest") {
+        AddStatRequest(detail::GetSuggestStatRequest(req_dict));
     } else {
         throw std::logic_error("json_reader::ProcessOneStat: unsupported request \"" + std::string(type) + "\"\n");
     }
@@ -247,6 +343,64 @@ json::Dict JSONPrinter::ProcessStopRequest (const request_handler::StopInfo& sto
                   .EndDict().Build().AsDict();
 }
 
+json::Dict JSONPrinter::ProcessDirectBusesRequest (const request_handler::DirectBusesInfo& direct_buses_info){
+    using namespace std::literals;
+
+    const domain::DirectBusesInfo& info = direct_buses_info.info;
+
+    json::Builder builder{};
+
+    builder.StartDict();
+
+    if (info.was_found) {
+        json::Array buses(info.buses.size());
+        std::transform(info.buses.begin(), info.buses.end(), buses.begin(),
+                       [](std::string_view name){
+                           return std::string(name);
+                       });
+        builder.Key("buses").Value(std::move(buses));
+    } else {
+        builder.Key("error_message").Value("not found"s);
+    }
+
+    return builder.Key("request_id").Value(direct_buses_info.id)
+                  .EndDict().Build().AsDict();
+}
+
+json::Dict JSONPrinter::ProcessNearbyRequest (const request_handler::NearbyInfo& nearby_info){
+    json::Builder builder{};
+
+    builder.StartDict().Key("stops").StartArray();
+    for (const domain::NearbyStop& stop : nearby_info.stops) {
+        builder.StartDict()
+                   .Key("name").Value(std::string(stop.name))
+                   .Key("distance").Value(stop.distance)
+               .EndDict();
+    }
+
+    return builder.EndArray()
+                  .Key("request_id").Value(nearby_info.id)
+                  .EndDict().Build().AsDict();
+}
+
+json::Dict JSONPrinter::ProcessSuggestRequest (const request_handler::SuggestInfo& suggest_info){
+    using namespace std::literals;
+
+    json::Builder builder{};
+
+    builder.StartDict().Key("items").StartArray();
+    for (const domain::NameSuggestion& item : suggest_info.items) {
+        builder.StartDict()
+                   .Key("type").Value(item.is_bus ? "Bus"s : "Stop"s)
+                   .Key("name").Value(std::string(item.name))
+               .EndDict();
+    }
+
+    return builder.EndArray()
+                  .Key("request_id").Value(suggest_info.id)
+                  .EndDict().Build().AsDict();
+}
+
 json::Dict JSONPrinter::ProcessBusRequest (const request_handler::BusInfo& bus_info){
     using namespace std::literals;
 
@@ -283,9 +437,46 @@ void JSONPrinter::Print(request_handler::RouteInfo& request) {
 
     builder.StartDict().Key("request_id").Value(request.id)
                        .Key("total_time").Value(request.total_time)
-                       .Key("items").StartArray();
+                       .Key("items");
+    AddRouteItems(builder, request.items);
+
+    answers_.push_back(builder.EndDict().Build());
+}
+
+void JSONPrinter::Print(request_handler::ParetoRouteInfo& request) {
+    using namespace std::literals;
+    json::Builder builder{};
+
+    if (request.routes.empty()) {
+        builder.StartDict().Key("request_id").Value(request.id)
+                       .Key("error_message").Value("not found"s)
+                       .EndDict();
+        answers_.push_back(builder.Build());
+        return;
+    }
+
+    builder.StartDict().Key("request_id").Value(request.id)
+                       .Key("routes").StartArray();
+
+    for (const request_handler::RouteInfo& route : request.routes) {
+        const int rides = std::count_if(route.items.begin(), route.items.end(), [](const request_handler::RouteItem& item) {
+            return item.type == request_handler::ItemType::Bus;
+        });
+        builder.StartDict().Key("total_time").Value(route.total_time)
+                           .Key("transfers").Value(std::max(0, rides - 1))
+                           .Key("items");
+        AddRouteItems(builder, route.items);
+        builder.EndDict();
+    }
+
+    answers_.push_back(builder.EndArray().EndDict().Build());
+}
+
+void JSONPrinter::AddRouteItems(json::Builder& builder, const std::vector<request_handler::RouteItem>& items) {
+    using namespace std::literals;
+    builder.StartArray();
 
-    for (request_handler::RouteItem& item : request.items) {
+    for (const request_handler::RouteItem& item : items) {
         builder.StartDict().Key("time").Value(item.time);
 
         if (item.type == request_handler::ItemType::Bus) {
@@ -300,8 +491,7 @@ void JSONPrinter::Print(request_handler::RouteInfo& request) {
         builder.EndDict();
     }
 
-
-    answers_.push_back(builder.EndArray().EndDict().Build());
+    builder.EndArray();
 }
 
 void JSONPrinter::Print(request_handler::MapInfo& request) {
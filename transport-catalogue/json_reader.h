@@ -46,9 +46,22 @@ public:
         answers_.push_back(ProcessStopRequest(request));
     }
 
+    void Print(const request_handler::DirectBusesInfo& request) override {
+        answers_.push_back(ProcessDirectBusesRequest(request));
+    }
+
+    void Print(const request_handler::NearbyInfo& request) override {
+        answers_.push_back(ProcessNearbyRequest(request));
+    }
+
+    void Print(const request_handler::SuggestInfo& request) override {
+        answers_.push_back(ProcessSuggestRequest(request));
+    }
+
     void Print(request_handler::MapInfo& request) override;
 
     void Print(request_handler::RouteInfo& request) override;
+    void Print(request_handler::ParetoRouteInfo& request) override;
 
     void RenderAll() override {
         json::Print(json::Document{answers_}, out_);
@@ -62,6 +75,10 @@ public:
 protected:
     json::Dict ProcessStopRequest (const request_handler::StopInfo& request);
     json::Dict ProcessBusRequest (const request_handler::BusInfo& request);
+    json::Dict ProcessDirectBusesRequest (const request_handler::DirectBusesInfo& request);
+    json::Dict ProcessNearbyRequest (const request_handler::NearbyInfo& request);
+    json::Dict ProcessSuggestRequest (const request_handler::SuggestInfo& request);
+    static void AddRouteItems(json::Builder& builder, const std::vector<request_handler::RouteItem>& items);
 
     std::ostream& out_;
     json::Array answers_;
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "graph.h"
+#include "batched_paths.h"
+#include "shortest_paths.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Travel times to and from a few landmark vertexes (ALT). By the triangle inequality they give
+// a lower bound of the distance between any two vertexes, which directs A* to the target.
+// Tables take O(L * V) memory instead of O(V^2) of all-pairs routes.
+template <typename Weight>
+class Landmarks {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+    static_assert(std::numeric_limits<Weight>::has_infinity, "Unreachable vertexes need an infinite weight");
+
+public:
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::infinity();
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    Landmarks() = default;
+
+    // Picks count landmarks by farthest-point selection and computes their tables
+    Landmarks(const Graph& graph, size_t count);
+
+    // Tables read from a base, distances are indexed by vertex * landmarks number + landmark
+    Landmarks(std::vector<VertexId> vertexes, std::vector<Weight> distances_to,
+              std::vector<Weight> distances_from);
+
+    const std::vector<VertexId>& GetVertexes() const {
+        return vertexes_;
+    }
+
+    // d(vertex, landmark), UNREACHABLE if there is no path
+    const std::vector<Weight>& GetDistancesTo() const {
+        return distances_to_;
+    }
+
+    // d(landmark, vertex), UNREACHABLE if there is no path
+    const std::vector<Weight>& GetDistancesFrom() const {
+        return distances_from_;
+    }
+
+    // UNREACHABLE if the tables prove there is no path
+    Weight GetLowerBound(VertexId from, VertexId to) const;
+
+    // A* search over the graph the tables were computed for
+    std::optional<RouteInfo> FindRoute(const Graph& graph, VertexId from, VertexId to) const;
+
+private:
+    void CheckSizes() const;
+
+    std::vector<VertexId> vertexes_;
+    std::vector<Weight> distances_to_;
+    std::vector<Weight> distances_from_;
+};
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(const Graph& graph, size_t count) {
+    const size_t vertex_count = graph.GetVertexCount();
+    count = std::min(count, vertex_count);
+    if (count == 0) {
+        return;
+    }
+
+    auto get_weights = [vertex_count](const ShortestPathsTree<Weight>& tree, std::vector<Weight>& weights) {
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            weights[vertex] = tree.GetWeight(vertex).value_or(UNREACHABLE);
+        }
+    };
+
+    // Every next landmark is the vertex farthest from those chosen, vertexes no landmark
+    // reaches come first. So each component gets a landmark before any one gets a second.
+    std::vector<Weight> weights(vertex_count);
+    get_weights(ShortestPathsTree<Weight>(graph, 0), weights);
+    std::vector<Weight> nearest(vertex_count, UNREACHABLE);
+    std::vector<bool> is_landmark(vertex_count, false);
+
+    for (size_t i = 0; i < count; ++i) {
+        VertexId farthest = 0;
+        bool found = false;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (!is_landmark[vertex] && (!found || weights[vertex] > weights[farthest])) {
+                farthest = vertex;
+                found = true;
+            }
+        }
+        vertexes_.push_back(farthest);
+        is_landmark[farthest] = true;
+
+        get_weights(ShortestPathsTree<Weight>(graph, farthest), weights);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            nearest[vertex] = std::min(nearest[vertex], weights[vertex]);
+        }
+        weights = nearest;
+    }
+
+    // Distances to landmarks are distances from them over the reversed graph
+    Graph reversed(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const Edge<Weight>& edge = graph.GetEdge(edge_id);
+        reversed.AddEdge({edge.to, edge.from, edge.weight});
+    }
+
+    distances_to_.assign(vertex_count * count, UNREACHABLE);
+    distances_from_.assign(vertex_count * count, UNREACHABLE);
+
+    using Paths = BatchedShortestPaths<Weight>;
+    const Paths forward(graph);
+    const Paths backward(reversed);
+    for (size_t begin = 0; begin < count; begin += Paths::LANES_NUMBER) {
+        const size_t end = std::min(count, begin + Paths::LANES_NUMBER);
+        std::vector<VertexId> sources(vertexes_.begin() + begin, vertexes_.begin() + end);
+        const typename Paths::Trees from_trees = forward.Search(sources);
+        const typename Paths::Trees to_trees = backward.Search(sources);
+        for (size_t lane = 0; lane < sources.size(); ++lane) {
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                distances_from_[vertex * count + begin + lane] = from_trees.GetWeight(lane, vertex).value_or(UNREACHABLE);
+                distances_to_[vertex * count + begin + lane] = to_trees.GetWeight(lane, vertex).value_or(UNREACHABLE);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(std::vector<VertexId> vertexes, std::vector<Weight> distances_to,
+                             std::vector<Weight> distances_from)
+    : vertexes_(std::move(vertexes))
+    , distances_to_(std::move(distances_to))
+    , distances_from_(std::move(distances_from))
+{
+    CheckSizes();
+}
+
+template <typename Weight>
+void Landmarks<Weight>::CheckSizes() const {
+    if (distances_to_.size() != distances_from_.size()
+        || (vertexes_.empty() ? !distances_to_.empty() : distances_to_.size() % vertexes_.size() != 0))
+    {
+        throw std::invalid_argument("Landmarks: tables don't match landmarks number");
+    }
+}
+
+template <typename Weight>
+Weight Landmarks<Weight>::GetLowerBound(VertexId from, VertexId to) const {
+    const size_t count = vertexes_.size();
+    Weight result{};
+    for (size_t i = 0; i < count; ++i) {
+        // d(from, to) >= d(from, l) - d(to, l), and from can't reach to if to reaches l but from doesn't
+        const Weight from_to_landmark = distances_to_[from * count + i];
+        const Weight to_to_landmark = distances_to_[to * count + i];
+        if (to_to_landmark != UNREACHABLE) {
+            if (from_to_landmark == UNREACHABLE) {
+                return UNREACHABLE;
+            }
+            result = std::max(result, from_to_landmark - to_to_landmark);
+        }
+        // d(from, to) >= d(l, to) - d(l, from), and to isn't reachable if l reaches from but not to
+        const Weight landmark_to_from = distances_from_[from * count + i];
+        const Weight landmark_to_to = distances_from_[to * count + i];
+        if (landmark_to_from != UNREACHABLE) {
+            if (landmark_to_to == UNREACHABLE) {
+                return UNREACHABLE;
+            }
+            result = std::max(result, landmark_to_to - landmark_to_from);
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+std::optional<typename Landmarks<Weight>::RouteInfo>
+Landmarks<Weight>::FindRoute(const Graph& graph, VertexId from, VertexId to) const {
+    if (GetLowerBound(from, to) == UNREACHABLE) {
+        return std::nullopt;
+    }
+
+    struct VertexData {
+        Weight weight;
+        std::optional<EdgeId> prev_edge;
+    };
+    std::vector<std::optional<VertexData>> vertexes_data(graph.GetVertexCount());
+    std::vector<bool> settled(graph.GetVertexCount(), false);
+
+    // Ordered by weight plus lower bound of the rest of the route
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    vertexes_data.at(from) = VertexData{Weight{}, std::nullopt};
+    queue.push({GetLowerBound(from, to), from});
+
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (settled[vertex]) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        settled[vertex] = true;
+
+        const Weight weight = vertexes_data[vertex]->weight;
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            auto& vertex_data = vertexes_data[edge.to];
+            if (vertex_data && !(candidate_weight < vertex_data->weight)) {
+                continue;
+            }
+            const Weight bound = GetLowerBound(edge.to, to);
+            if (bound == UNREACHABLE) {
+                continue;
+            }
+            vertex_data = VertexData{candidate_weight, edge_id};
+            settled[edge.to] = false;
+            queue.push({candidate_weight + bound, edge.to});
+        }
+    }
+
+    if (!vertexes_data[to]) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = vertexes_data[to]->prev_edge;
+         edge_id;
+         edge_id = vertexes_data[graph.GetEdge(*edge_id).from]->prev_edge)
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{vertexes_data[to]->weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+// Keeps at most capacity values, the least recently used one is evicted first
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    explicit LruCache(size_t capacity) : capacity_(capacity) {
+        positions_.reserve(capacity);
+    }
+
+    // Returns nullptr if there is no such key. The pointer is valid until the next Insert() or Clear()
+    const Value* Find(const Key& key) {
+        auto it = positions_.find(key);
+        if (it == positions_.end()) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        ++stats_.hits;
+        items_.splice(items_.begin(), items_, it->second);
+        return &it->second->second;
+    }
+
+    // Unlike Find() doesn't touch usage order and statistics
+    bool Contains(const Key& key) const {
+        return positions_.count(key) != 0;
+    }
+
+    void Insert(const Key& key, Value value) {
+        if (capacity_ == 0) {
+            return;
+        }
+        auto it = positions_.find(key);
+        if (it != positions_.end()) {
+            it->second->second = std::move(value);
+            items_.splice(items_.begin(), items_, it->second);
+            return;
+        }
+        if (items_.size() == capacity_) {
+            positions_.erase(items_.back().first);
+            items_.pop_back();
+        }
+        items_.emplace_front(key, std::move(value));
+        positions_[key] = items_.begin();
+    }
+
+    // Removes values the predicate holds for, returns their number
+    template <typename Predicate>
+    size_t EraseIf(Predicate predicate) {
+        size_t result = 0;
+        for (auto it = items_.begin(); it != items_.end(); ) {
+            if (predicate(it->first, it->second)) {
+                positions_.erase(it->first);
+                it = items_.erase(it);
+                ++result;
+            } else {
+                ++it;
+            }
+        }
+        return result;
+    }
+
+    void Clear() {
+        items_.clear();
+        positions_.clear();
+    }
+
+    size_t GetSize() const {
+        return items_.size();
+    }
+
+    Stats GetStats() const {
+        return stats_;
+    }
+
+private:
+    using Items = std::list<std::pair<Key, Value>>;
+
+    size_t capacity_;
+    Items items_;
+    std::unordered_map<Key, typename Items::iterator, Hash> positions_;
+    Stats stats_;
+};
+
+}  // namespace cache
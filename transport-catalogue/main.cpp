@@ -4,36 +4,51 @@
 #include <fstream>
 #include <string_view>
 #include <iostream>
+#include <exception>
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base [--update <old_base>]|process_requests]\n"sv;
 }
 
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc != 2 && argc != 4) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
+    if (argc == 4 && (mode != "make_base"sv || argv[2] != "--update"sv)) {
+        PrintUsage();
+        return 1;
+    }
+
     stream_input_json::JSONReader reader(std::cin);
     reader.Read();
 
-    if (mode == "make_base"sv) {
-        map_renderer::MapRendererJSON renderer;
-        request_handler::CatalogueSerializationHandler serializator(reader.GetSerializationSettings());
-        serializator.Serialize(reader, renderer);
-    } else if (mode == "process_requests"sv) {
-        stream_input_json::JSONPrinter printer(std::cout);
-        map_renderer::MapRendererJSON renderer;
-        request_handler::CatalogueDeserializationHandler deserializator(reader.GetSerializationSettings());
-        deserializator.Deserialize(printer, renderer, reader);
-    } else {
-        PrintUsage();
+    try {
+        if (mode == "make_base"sv) {
+            map_renderer::MapRendererJSON renderer;
+            request_handler::SerializationSettings settings = reader.GetSerializationSettings();
+            if (argc == 4) {
+                settings.previous_file = argv[3];
+            }
+            request_handler::CatalogueSerializationHandler serializator(settings);
+            serializator.Serialize(reader, renderer);
+        } else if (mode == "process_requests"sv) {
+            stream_input_json::JSONPrinter printer(std::cout);
+            map_renderer::MapRendererJSON renderer;
+            request_handler::CatalogueDeserializationHandler deserializator(reader.GetSerializationSettings());
+            deserializator.Deserialize(printer, renderer, reader);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what();
         return 1;
     }
 
@@ -160,20 +160,19 @@ RenderSettings MapRendererJSON::ConvertRenderSettings(const request_handler::Ren
 }
 
 
-void MapRendererJSON::ComputeStopPoints
-(const std::vector<std::pair<std::string_view, geo::Coordinates>>& stops) {
+void MapRendererJSON::ComputeStopPoints(domain::StopsUsed stops) {
     std::vector<geo::Coordinates> coordinates(stops.size());
     RenderSettings& settings = settings_.value();
 
     std::transform(stops.begin(), stops.end(), coordinates.begin(),
-                   [](const std::pair<const std::string_view, geo::Coordinates>& stop){
+                   [](const std::pair<std::string_view, geo::Coordinates>& stop){
                         return stop.second;
                    });
     detail::SphereProjector projector(coordinates.begin(), coordinates.end(),
                                       settings.width, settings.height, settings.padding);
 
     std::for_each(stops.begin(), stops.end(),
-                   [&projector, this](const std::pair<const std::string_view, geo::Coordinates>& stop){
+                   [&projector, this](const std::pair<std::string_view, geo::Coordinates>& stop){
                         stops_points_[stop.first] = projector(stop.second);
                    });
 
@@ -248,7 +247,7 @@ void MapRendererJSON::SetBusLineSettings(svg::Polyline& line, const svg::Color&
         .SetStrokeWidth(settings.line_width);
 }
 
-void MapRendererJSON::RenderBuses(const std::set<domain::BusForRender>& buses) {
+void MapRendererJSON::RenderBuses(domain::BusesForRender buses) {
     int current_color_index = 0;
     const std::vector<svg::Color>& palette = settings_.value().color_palette;
     const int colors_count = palette.size();
@@ -261,23 +260,23 @@ void MapRendererJSON::RenderBuses(const std::set<domain::BusForRender>& buses) {
     SetBusLabelSettings(underlayer, true);
     SetBusLabelSettings(label, false);
 
-    for (const domain::BusForRender& bus : buses) {
+    for (const domain::Bus* bus : buses) {
         svg::Color current_color = palette[current_color_index % colors_count];
         current_color_index++;
 
         svg::Polyline line;
         SetBusLineSettings(line, current_color);
 
-        for(std::string_view stop : bus.stops) {
-            line.AddPoint(stops_points_.at(stop));
+        for(const domain::Stop* stop : bus->GetRoute()) {
+            line.AddPoint(stops_points_.at(stop->name));
         }
 
         doc_.Add(line);
 
-        svg::Point point = stops_points_.at(bus.stops[0]);
+        svg::Point point = stops_points_.at(bus->stops.front()->name);
 
-        underlayer.SetData(std::string(bus.name));
-        label.SetData(std::string(bus.name));
+        underlayer.SetData(std::string(bus->name));
+        label.SetData(std::string(bus->name));
         label.SetFillColor(current_color);
         underlayer.SetPosition(point);
         label.SetPosition(point);
@@ -285,10 +284,9 @@ void MapRendererJSON::RenderBuses(const std::set<domain::BusForRender>& buses) {
         bus_labels.push_back(underlayer);
         bus_labels.push_back(label);
 
-        if (!bus.is_roundtrip) {
-            int last_stop_index = (bus.stops.size() - 1) / 2;
-            if (bus.stops[0] != bus.stops[last_stop_index]) {
-                point = stops_points_.at(bus.stops[last_stop_index]);
+        if (!bus->is_roundtrip) {
+            if (bus->stops.front() != bus->stops.back()) {
+                point = stops_points_.at(bus->stops.back()->name);
                 underlayer.SetPosition(point);
                 label.SetPosition(point);
                 bus_labels.push_back(underlayer);
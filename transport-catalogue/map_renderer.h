@@ -41,7 +41,7 @@ public:
     std::map<std::string_view, domain::Point>
     GetStopPoints() const;
 
-    void ComputeStopPoints(const std::vector<std::pair<std::string_view, geo::Coordinates>>& stops);
+    void ComputeStopPoints(domain::StopsUsed stops);
 
     void RenderMap(const request_handler::MapData& data, std::ostream& out) override;
 
@@ -54,7 +54,7 @@ private:
     void SetBusLabelSettings(svg::Text& label, bool underlayer);
     void RenderBusLabel(const domain::BusInfo& bus, const svg::Color&);
     void SetBusLineSettings(svg::Polyline& line, const svg::Color& color);
-    void RenderBuses(const std::set<domain::BusForRender>&);
+    void RenderBuses(domain::BusesForRender);
 
     std::optional<RenderSettings> settings_;
     svg::Document doc_;
@@ -0,0 +1,62 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace domain {
+
+NameIndex::NameIndex(const std::vector<std::string_view>& names) {
+    Sort(names);
+}
+
+NameIndex::NameIndex(const std::vector<std::string_view>& names, const std::vector<uint32_t>& order) {
+    if (order.size() != names.size()) {
+        Sort(names);
+        return;
+    }
+
+    // The order is checked to be a sorted permutation, a broken or outdated base gets sorted again
+    std::vector<bool> seen(names.size(), false);
+    sorted_names_.reserve(names.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        const uint32_t position = order[i];
+        if (position >= names.size() || seen[position]
+            || (i > 0 && (names[position] < sorted_names_.back()
+                          || (names[position] == sorted_names_.back() && position < order[i - 1])))) {
+            Sort(names);
+            return;
+        }
+        seen[position] = true;
+        sorted_names_.push_back(names[position]);
+    }
+    order_ = order;
+}
+
+std::vector<std::string_view> NameIndex::FindByPrefix(std::string_view prefix, size_t count) const {
+    std::vector<std::string_view> result;
+    auto it = std::lower_bound(sorted_names_.begin(), sorted_names_.end(), prefix);
+    for (; it != sorted_names_.end() && result.size() < count && it->substr(0, prefix.size()) == prefix; ++it) {
+        // Equal names are adjacent, only the first of them is taken
+        if (result.empty() || result.back() != *it) {
+            result.push_back(*it);
+        }
+    }
+    return result;
+}
+
+void NameIndex::Sort(const std::vector<std::string_view>& names) {
+    order_.resize(names.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    // Stable, so of equal names the first added goes first
+    std::stable_sort(order_.begin(), order_.end(), [&names](uint32_t lhs, uint32_t rhs) {
+        return names[lhs] < names[rhs];
+    });
+
+    sorted_names_.clear();
+    sorted_names_.reserve(names.size());
+    for (uint32_t position : order_) {
+        sorted_names_.push_back(names[position]);
+    }
+}
+
+} // namespace domain
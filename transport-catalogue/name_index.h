@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace domain {
+
+// Names in lexicographic order, equal ones in the order of their positions. The ones starting
+// with a prefix are a contiguous range after its lower bound. The order is kept as positions of
+// names in the catalogue, so a base stores it as an array of ids and nothing is sorted again
+// when the base is read.
+class NameIndex {
+public:
+    NameIndex() = default;
+
+    // Sorts names
+    explicit NameIndex(const std::vector<std::string_view>& names);
+
+    // Takes the order of names as is if it is the sorted one, otherwise sorts them
+    NameIndex(const std::vector<std::string_view>& names, const std::vector<uint32_t>& order);
+
+    // At most count distinct names starting with prefix, in lexicographic order
+    std::vector<std::string_view> FindByPrefix(std::string_view prefix, size_t count) const;
+
+    // Positions of names in lexicographic order
+    const std::vector<uint32_t>& GetOrder() const {
+        return order_;
+    }
+
+private:
+    void Sort(const std::vector<std::string_view>& names);
+
+    std::vector<std::string_view> sorted_names_;
+    std::vector<uint32_t> order_;
+};
+
+} // namespace domain
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+template <typename Weight>
+struct ParetoRoute {
+    Weight weight;
+    std::vector<EdgeId> edges;
+};
+
+// Routes Pareto-optimal on weight and number of edges, found by rounds as in RAPTOR: round k
+// gives the lightest routes of at most k edges and relaxes only edges from vertexes improved
+// in round k - 1. Every round is one flat row of weights and last edges per vertex, and a
+// route is kept only if it beats the best one to the target found so far.
+// Routes are ordered by edges number, every next one is strictly lighter.
+template <typename Weight>
+std::vector<ParetoRoute<Weight>> FindParetoRoutes(const DirectedWeightedGraph<Weight>& graph,
+                                                  VertexId from, VertexId to, size_t max_edges) {
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<ParetoRoute<Weight>> result;
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("FindParetoRoutes: no such vertex");
+    }
+    if (from == to) {
+        result.push_back({Weight{}, {}});
+        return result;
+    }
+
+    // Row k is [k * vertex_count, (k + 1) * vertex_count), edges are NO_EDGE where round k
+    // didn't improve the weight of round k - 1
+    std::vector<Weight> weights(vertex_count, UNREACHED);
+    std::vector<EdgeId> last_edges(vertex_count, NO_EDGE);
+    weights[from] = Weight{};
+
+    std::vector<VertexId> marked{from};
+    std::vector<VertexId> next_marked;
+    std::vector<bool> is_marked(vertex_count, false);
+    Weight target_weight = UNREACHED;
+
+    for (size_t round = 1; round <= max_edges && !marked.empty(); ++round) {
+        const size_t previous_row = (round - 1) * vertex_count;
+        const size_t row = round * vertex_count;
+        weights.resize(row + vertex_count);
+        std::copy_n(weights.begin() + previous_row, vertex_count, weights.begin() + row);
+        last_edges.resize(row + vertex_count, NO_EDGE);
+
+        for (VertexId vertex : marked) {
+            const Weight weight = weights[previous_row + vertex];
+            for (EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const Edge<Weight>& edge = graph.GetEdge(edge_id);
+                if (edge.weight < Weight{}) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                const Weight candidate = weight + edge.weight;
+                if (candidate < weights[row + edge.to] && candidate < target_weight) {
+                    weights[row + edge.to] = candidate;
+                    last_edges[row + edge.to] = edge_id;
+                    // Routes through the target can't lead to a lighter one to it
+                    if (edge.to != to && !is_marked[edge.to]) {
+                        is_marked[edge.to] = true;
+                        next_marked.push_back(edge.to);
+                    }
+                }
+            }
+        }
+
+        if (weights[row + to] < target_weight) {
+            target_weight = weights[row + to];
+            std::vector<EdgeId> edges;
+            size_t edges_round = round;
+            for (VertexId vertex = to; vertex != from; --edges_round) {
+                while (last_edges[edges_round * vertex_count + vertex] == NO_EDGE) {
+                    --edges_round;
+                }
+                const EdgeId edge_id = last_edges[edges_round * vertex_count + vertex];
+                edges.push_back(edge_id);
+                vertex = graph.GetEdge(edge_id).from;
+            }
+            std::reverse(edges.begin(), edges.end());
+            result.push_back({target_weight, std::move(edges)});
+        }
+
+        for (VertexId vertex : next_marked) {
+            is_marked[vertex] = false;
+        }
+        marked.swap(next_marked);
+        next_marked.clear();
+    }
+
+    return result;
+}
+
+}  // namespace graph
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Monotone priority queue for unsigned integer keys: a pushed key may not be less than
+// the last popped one, as in Dijkstra's algorithm. Every item moves between buckets at most
+// digits times, so a push costs O(1) and a pop O(digits) amortized, with no comparisons of items.
+template <typename Key, typename Value>
+class RadixHeap {
+    static_assert(std::is_integral_v<Key> && std::is_unsigned_v<Key>,
+                  "RadixHeap keys should be unsigned integers");
+
+public:
+    using Item = std::pair<Key, Value>;
+
+    bool Empty() const {
+        return size_ == 0;
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+    void Push(Key key, Value value) {
+        assert(key >= last_);
+        buckets_[GetBucketIndex(key)].emplace_back(key, std::move(value));
+        ++size_;
+    }
+
+    // Returns one of the items with the least key
+    Item Pop() {
+        assert(!Empty());
+        if (buckets_[0].empty()) {
+            Redistribute();
+        }
+        Item result = std::move(buckets_[0].back());
+        buckets_[0].pop_back();
+        --size_;
+        return result;
+    }
+
+private:
+    static constexpr size_t DIGITS = std::numeric_limits<Key>::digits;
+
+    // Bucket i holds keys differing from last_ in bit i - 1 as the highest one
+    size_t GetBucketIndex(Key key) const {
+        Key difference = key ^ last_;
+        if (difference == 0) {
+            return 0;
+        }
+#if defined(__GNUC__)
+        if constexpr (DIGITS <= std::numeric_limits<unsigned long long>::digits) {
+            return std::numeric_limits<unsigned long long>::digits
+                   - __builtin_clzll(static_cast<unsigned long long>(difference));
+        }
+#endif
+        size_t result = 0;
+        for (; difference != 0; difference >>= 1) {
+            ++result;
+        }
+        return result;
+    }
+
+    // Moves the least key of the first nonempty bucket to last_. All items of that bucket
+    // then land in lower buckets, and the least ones in bucket 0.
+    void Redistribute() {
+        size_t index = 1;
+        while (buckets_[index].empty()) {
+            ++index;
+        }
+
+        std::vector<Item>& bucket = buckets_[index];
+        last_ = bucket.front().first;
+        for (const Item& item : bucket) {
+            if (item.first < last_) {
+                last_ = item.first;
+            }
+        }
+
+        for (Item& item : bucket) {
+            buckets_[GetBucketIndex(item.first)].push_back(std::move(item));
+        }
+        bucket.clear();
+    }
+
+    std::array<std::vector<Item>, DIGITS + 1> buckets_;
+    Key last_ = 0;
+    size_t size_ = 0;
+};
+
+}  // namespace graph
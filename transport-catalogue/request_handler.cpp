@@ -12,6 +12,7 @@
 #include <unordered_map>
 #include <optional>
 #include <algorithm>
+#include <limits>
 
 
 namespace request_handler {
@@ -48,6 +49,25 @@ void StatRequestHandler::Process(BusInfoRequest& request) {
     printer_.Print(info);
 }
 
+void StatRequestHandler::Process(DirectBusesRequest& request) {
+    DirectBusesInfo info{catalogue_.GetDirectBuses(request.stop_from, request.stop_to), request.id};
+    printer_.Print(info);
+}
+
+void StatRequestHandler::Process(NearbyRequest& request) {
+    NearbyInfo info;
+    info.id = request.id;
+    info.stops = catalogue_.GetNearbyStops(request.center,
+                                           request.count ? *request.count : std::numeric_limits<size_t>::max(),
+                                           request.radius.value_or(std::numeric_limits<double>::infinity()));
+    printer_.Print(info);
+}
+
+void StatRequestHandler::Process(SuggestRequest& request) {
+    SuggestInfo info{catalogue_.Suggest(request.prefix, request.count), request.id};
+    printer_.Print(info);
+}
+
 void StatRequestHandler::Process(MapInfoRequest& request) {
         std::ostringstream out;
 
@@ -62,23 +82,111 @@ void StatRequestHandler::Process(MapInfoRequest& request) {
 
 
 void StatRequestHandler::Process(RoutingInfoRequest& request) {
+    transport_router::RouterBase& router = GetRouter();
+    const transport_router::RoutingMetric metric{request.wait_time.value_or(router.GetWaitTime()),
+                                                 request.bus_velocity.value_or(router.GetBusVelocity())};
+
+    // Answers of other settings and Pareto sets are neither planned nor cached
+    if (request.max_transfers) {
+        ParetoRouteInfo pareto_info;
+        pareto_info.id = request.id;
+        for (const transport_router::RouterItems& route_items
+             : router.FindParetoRoutes(request.stop_from, request.stop_to, *request.max_transfers, metric)) {
+            pareto_info.routes.push_back(MakeRouteInfo(route_items, metric.wait_time));
+        }
+        printer_.Print(pareto_info);
+        return;
+    }
+
+    RouteInfo route_info;
+    if (request.wait_time || request.bus_velocity) {
+        route_info = MakeRouteInfo(router.FindRoute(request.stop_from, request.stop_to, metric), metric.wait_time);
+    } else {
+        route_info = GetRouteInfo(request.stop_from, request.stop_to);
+    }
+    route_info.id = request.id;
+    printer_.Print(route_info);
+}
+
+transport_router::RouterBase& StatRequestHandler::GetRouter() {
     if (!router_) {
         router_ = std::make_unique<transport_router::TransportRouter>(routing_settings_,
-                                                                      DistanceComputer(catalogue_),
+                                                                      distance_computer_,
                                                                       GetMapData());
     }
+    return *router_;
+}
+
+RouteInfo StatRequestHandler::GetRouteInfo(std::string_view from, std::string_view to) {
+    transport_router::RouterBase& router = GetRouter();
+
+    std::optional<transport_router::VertexId> from_id = router.GetStopId(from);
+    std::optional<transport_router::VertexId> to_id   = router.GetStopId(to);
+
+    if (from == to || !from_id || !to_id) {
+        return MakeRouteInfo(router.FindRoute(from, to), router.GetWaitTime());
+    }
 
-    transport_router::RouterItems route_items = router_->FindRoute(request.stop_from, request.stop_to);
+    const StopIdPair key{*from_id, *to_id};
+    if (const RouteInfo* cached = route_cache_.Find(key)) {
+        return *cached;
+    }
 
     RouteInfo route_info;
-    route_info.id = request.id;
+    auto planned = planned_routes_.find(key);
+    if (planned != planned_routes_.end()) {
+        route_info = planned->second;
+    } else {
+        route_info = MakeRouteInfo(router.FindRoute(from, to), router.GetWaitTime());
+    }
+    route_cache_.Insert(key, route_info);
+    return route_info;
+}
+
+void StatRequestHandler::Plan(RoutingInfoRequest& request) {
+    transport_router::RouterBase& router = GetRouter();
+    if (!router.IsBatchingRoutes()) {
+        return;
+    }
+
+    std::optional<transport_router::VertexId> from_id = router.GetStopId(request.stop_from);
+    std::optional<transport_router::VertexId> to_id   = router.GetStopId(request.stop_to);
+
+    if (request.stop_from == request.stop_to || !from_id || !to_id
+        || request.wait_time || request.bus_velocity || request.max_transfers
+        || route_cache_.Contains({*from_id, *to_id})) {
+        return;
+    }
+
+    PlannedOrigin& origin = planned_origins_[*from_id];
+    origin.name = request.stop_from;
+    if (std::find(origin.destination_ids.begin(), origin.destination_ids.end(), *to_id)
+        == origin.destination_ids.end()) {
+        origin.destinations.push_back(request.stop_to);
+        origin.destination_ids.push_back(*to_id);
+    }
+}
+
+void StatRequestHandler::FindPlannedRoutes() {
+    transport_router::RouterBase& router = GetRouter();
+    for (auto& [from_id, origin] : planned_origins_) {
+        std::vector<transport_router::RouterItems> routes = router.FindRoutes(origin.name, origin.destinations);
+
+        for (size_t i = 0; i < routes.size(); ++i) {
+            planned_routes_[{from_id, origin.destination_ids[i]}] = MakeRouteInfo(routes[i], router.GetWaitTime());
+        }
+    }
+    planned_origins_.clear();
+}
+
+RouteInfo StatRequestHandler::MakeRouteInfo(const transport_router::RouterItems& route_items, int wait_time) {
+    RouteInfo route_info;
 
     route_info.total_time = route_items.total_time;
-    int wait_time = router_->GetWaitTime();
 
-    for (size_t i = 0; i < route_items.items.size(); ++i) {
-        transport_router::RouterItem& item = route_items.items[i];
+    route_info.items.reserve(route_items.items.size() * 2);
 
+    for (const transport_router::RouterItem& item : route_items.items) {
         RouteItem wait_item;
 
         wait_item.type = ItemType::Wait;
@@ -97,12 +205,14 @@ void StatRequestHandler::Process(RoutingInfoRequest& request) {
         route_info.items.push_back(bus_item);
     }
 
-    printer_.Print(route_info);
+    return route_info;
 }
 
-const MapData& StatRequestHandler::GetMapData() const {
-    static const MapData data = MapData(catalogue_.GetStopsUsed(), catalogue_.GetBusesForRender());
-    return data;
+const MapData& StatRequestHandler::GetMapData() {
+    if (!map_data_) {
+        map_data_.emplace(catalogue_.GetStopsUsed(), catalogue_.GetBusesForRender());
+    }
+    return *map_data_;
 }
 
 void StatRequestHandler::ProcessRequests(RequestReader& filled_reader) {
@@ -110,14 +220,29 @@ void StatRequestHandler::ProcessRequests(RequestReader& filled_reader) {
 }
 
 void StatRequestHandler::ProcessRequests(std::vector<std::unique_ptr<StatRequest>>& requests) {
+    for (std::unique_ptr<StatRequest>& request : requests) {
+        request.get()->PlanMeBy(*this);
+    }
+    FindPlannedRoutes();
+
     for (std::unique_ptr<StatRequest>& request : requests) {
         request.get()->ProcessMeBy(*this);
     }
+    planned_routes_.clear();
     printer_.RenderAll();
     printer_.Clear();
 }
 
 void CatalogueSerializationHandler::Serialize(RequestReader& reader, MapRenderer& renderer) {
+    // Previous base is read before the new one is written, so both may share one file.
+    // It is read first of all, so a bad one fails before the slow part.
+    std::optional<serialization::CatalogueDeserializator> previous_deserializator;
+    serialization::DeserializationData previous_data;
+    if (previous_file_) {
+        previous_deserializator.emplace(*previous_file_);
+        previous_data = previous_deserializator->Deserialize();
+    }
+
     TransportCatalogue catalogue;
     request_handler::BaseRequestHandler br_handler(catalogue);
     br_handler.ProcessBaseRequests(reader);
@@ -138,13 +263,16 @@ void CatalogueSerializationHandler::Serialize(RequestReader& reader, MapRenderer
     auto render_settings = reader.GetSettings();
     auto stops           = catalogue.GetAllStops();
     auto stop_points     = renderer.GetStopPoints();
-    auto router_data     = router.GetSerializationData();
+    auto router_data     = previous_file_ ? router.GetSerializationData(previous_data.router_data)
+                                          : router.GetSerializationData();
 
     serialization::SerializationData data {stops, buses,
                                            distances,
                                            stop_points,
                                            render_settings,
-                                           router_data};
+                                           router_data,
+                                           catalogue.GetStopsOrder(),
+                                           catalogue.GetBusesOrder()};
 
     serializator.Serialize(data);
 }
@@ -184,6 +312,9 @@ void CatalogueDeserializationHandler::Deserialize(RequestPrinter& printer,
         catalogue.AddDistance(names.first, names.second, element.second);
     }
 
+    // Stops and buses were added in the order of the base, so its positions are valid here
+    catalogue.SetNamesOrder(catalogue_data.stops_by_name, catalogue_data.buses_by_name);
+
     renderer.SetRenderSettings(catalogue_data.render_settings);
     renderer.SetStopPoints(catalogue_data.stop_points);
 
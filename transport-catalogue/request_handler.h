@@ -1,6 +1,7 @@
 #pragma once
 
 #include "domain.h"
+#include <cstdint>
 #include <string_view>
 #include <string>
 #include <sstream>
@@ -8,8 +9,16 @@
 #include <optional>
 #include "transport_catalogue.h"
 #include <memory>
+#include <functional>
 #include <map>
 #include "svg.h"
+#include "graph.h"
+#include "components.h"
+#include "landmarks.h"
+#include "hub_labels.h"
+#include "lru_cache.h"
+#include "router_customization.h"
+#include "flat_hash_map.h"
 
 namespace transport_router {
 
@@ -21,18 +30,22 @@ struct WholeRoute {
     std::vector<VertexId> edges_ids;
 };
 
-using StopRoutes = std::unordered_map<VertexId, WholeRoute>;
+// Routes from one source vertex, ordered by destination vertex id
+using StopRoutes = std::vector<std::pair<VertexId, WholeRoute>>;
 
 struct DeserializedRouterItem {
     size_t name;
     size_t start;
+    size_t finish;
     double time;
     int count;
+    int64_t distance;
 };
 
-struct DeserializedRouterItems {
+struct RouteSpan {
     double total_time = -1;
-    std::vector<size_t> items;
+    uint32_t begin = 0;
+    uint32_t size = 0;
 };
 
 struct RouterItem {
@@ -40,6 +53,8 @@ struct RouterItem {
     std::string_view start;
     double time;
     int count;
+    // Road length in meters, time of other routing settings is computed from it
+    int64_t distance = 0;
 };
 
 struct RouterItems {
@@ -48,18 +63,32 @@ struct RouterItems {
 };
 
 struct RouterSerializationData {
-    const std::unordered_map<std::string_view, VertexId>& stop_vertexes;
+    const container::FlatHashMap<std::string_view, VertexId>& stop_vertexes;
     const std::vector<RouterItem>& edges;
-    std::unordered_map<VertexId, StopRoutes> data;
+    const graph::DirectedWeightedGraph<double>& graph;
+    const std::vector<uint32_t>& components;
+    // Builds routes of sources [begin, end) on demand, so rows can be written by small batches
+    std::function<std::vector<StopRoutes>(VertexId begin, VertexId end)> make_stops_routes;
     int wait_time;
     double bus_velocity;
+    // If one of them is set, the base stores it instead of routes of all sources
+    const graph::Landmarks<double>* landmarks = nullptr;
+    const graph::HubLabels<double>* hub_labels = nullptr;
 };
 
 struct LazyRouterData {
     std::vector<std::pair<std::string_view, size_t>> stops_ids;
     std::vector<std::pair<std::string_view, size_t>> buses_ids;
     std::vector<std::pair<size_t, DeserializedRouterItem>> edges;
-    std::unordered_map<size_t, std::unordered_map<size_t, DeserializedRouterItems>> routes;
+    // Routes exist only inside connected components of the router graph
+    graph::ComponentPairsIndex pairs_index;
+    // spans of routes between vertexes of one component, addressed by pairs_index
+    std::vector<RouteSpan> routes;
+    // edge ids of all routes, each route is a [begin, begin + size) slice
+    std::vector<uint32_t> route_edges;
+    // One of them is set if the base has no routes table, routes are then searched over edges
+    std::optional<graph::Landmarks<double>> landmarks;
+    std::optional<graph::HubLabels<double>> hub_labels;
     int wait_time;
     double bus_velocity;
 };
@@ -68,7 +97,28 @@ class RouterBase {
 public:
     RouterBase(int wait_time, double bus_velocity) : wait_time_(wait_time), bus_velocity_(bus_velocity) {}
     virtual RouterItems FindRoute(std::string_view from, std::string_view to) = 0;
+    // Route under other routing settings, searched over the graph customized for them
+    virtual RouterItems FindRoute(std::string_view from, std::string_view to, const RoutingMetric& metric) = 0;
+    // Routes Pareto-optimal on time and transfers, with at most max_transfers transfers.
+    // Fewer transfers go first, every next route is faster. Empty if there is no route.
+    virtual std::vector<RouterItems> FindParetoRoutes(std::string_view from, std::string_view to,
+                                                      size_t max_transfers, const RoutingMetric& metric) = 0;
+    // Routes from one stop to several others, routers may answer them all with one search
+    virtual std::vector<RouterItems> FindRoutes(std::string_view from, const std::vector<std::string_view>& to) {
+        std::vector<RouterItems> result;
+        result.reserve(to.size());
+        for (std::string_view stop_to : to) {
+            result.push_back(FindRoute(from, stop_to));
+        }
+        return result;
+    }
+    // Whether FindRoutes() shares one search among its routes, so they are worth planning
+    virtual bool IsBatchingRoutes() const {
+        return false;
+    }
     virtual RouterSerializationData GetSerializationData() = 0;
+    // Dense id of a stop in the router, std::nullopt if the stop has no buses
+    virtual std::optional<VertexId> GetStopId(std::string_view name) const = 0;
     int GetWaitTime () {return wait_time_;}
     double GetBusVelocity () {return bus_velocity_;}
 protected:
@@ -88,6 +138,21 @@ struct BusInfo {
     int id;
 };
 
+struct DirectBusesInfo {
+    domain::DirectBusesInfo info;
+    int id;
+};
+
+struct NearbyInfo {
+    std::vector<domain::NearbyStop> stops;
+    int id;
+};
+
+struct SuggestInfo {
+    std::vector<domain::NameSuggestion> items;
+    int id;
+};
+
 struct MapInfo {
     std::string map_str;
     int id;
@@ -112,6 +177,13 @@ struct RouteInfo {
     int id;
 };
 
+// Routes Pareto-optimal on time and transfers, fewer transfers first
+struct ParetoRouteInfo {
+    std::vector<RouteInfo> routes;
+
+    int id;
+};
+
 struct RenderSettings {
     double width;
     double height;
@@ -136,10 +208,18 @@ struct RenderSettings {
 struct RoutingSettings {
     double bus_velocity;
     int    wait_time;
+    // If set, routes are searched over integer weights in 1/time_units_per_minute of a minute
+    std::optional<int> time_units_per_minute;
+    // If set, the base stores tables of this many landmarks instead of routes of all pairs
+    std::optional<int> landmarks_count;
+    // If set, the base stores hub labels of all stops instead of routes of all pairs
+    bool hub_labels = false;
 };
 
 struct SerializationSettings {
     std::string file;
+    // Base built earlier from similar data, its routes are reused where still valid
+    std::optional<std::string> previous_file;
 };
 
 class RequestHandler;
@@ -162,6 +242,9 @@ struct StatRequest {
 
     virtual void ProcessMeBy(StatRequestHandler& handler) = 0;
 
+    // Called for every request of a batch before any of them is processed
+    virtual void PlanMeBy(StatRequestHandler& /*handler*/) {}
+
     virtual ~StatRequest() = default;
 };
 
@@ -169,6 +252,9 @@ struct StopInfoRequest;
 struct BusInfoRequest;
 struct MapInfoRequest;
 struct RoutingInfoRequest;
+struct DirectBusesRequest;
+struct NearbyRequest;
+struct SuggestRequest;
 
 class RequestReader{
 public:
@@ -218,8 +304,12 @@ class RequestPrinter{
 public:
     virtual void Print(const BusInfo&) = 0;
     virtual void Print(const StopInfo&) = 0;
+    virtual void Print(const DirectBusesInfo&) = 0;
+    virtual void Print(const NearbyInfo&) = 0;
+    virtual void Print(const SuggestInfo&) = 0;
     virtual void Print(MapInfo&) = 0;
     virtual void Print(RouteInfo&) = 0;
+    virtual void Print(ParetoRouteInfo&) = 0;
     virtual void RenderAll() = 0;
     virtual void Clear() = 0;
 protected:
@@ -227,14 +317,15 @@ protected:
     virtual ~RequestPrinter() = default;
 };
 
+// Views of the catalogue, which outlives the map data. AddStop() and AddBus() invalidate them.
 struct MapData{
-MapData(const std::vector<std::pair<std::string_view, geo::Coordinates>>& stops_used_in,
-        const std::set<domain::BusForRender>& buses_in) : stops_used(stops_used_in),
-                                                          buses(buses_in) {}
+MapData(domain::StopsUsed stops_used_in,
+        domain::BusesForRender buses_in) : stops_used(stops_used_in),
+                                           buses(buses_in) {}
 
 
-const std::vector<std::pair<std::string_view, geo::Coordinates>> stops_used;
-const std::set<domain::BusForRender> buses;
+const domain::StopsUsed stops_used;
+const domain::BusesForRender buses;
 };
 
 class MapRenderer{
@@ -242,7 +333,7 @@ public:
     virtual void SetRenderSettings (const RenderSettings& settings) = 0;
     virtual void RenderMap (const MapData& data, std::ostream& out) = 0;
     virtual void SetStopPoints(std::map<std::string, domain::Point>& stops_points) = 0;
-    virtual void ComputeStopPoints(const std::vector<std::pair<std::string_view, geo::Coordinates>>& stops) = 0;
+    virtual void ComputeStopPoints(domain::StopsUsed stops) = 0;
     virtual std::map<std::string_view, domain::Point>
     GetStopPoints() const  = 0;
 
@@ -267,33 +358,92 @@ public:
     void ProcessBaseRequests(RequestReader& filled_reader);
 };
 
+using StopIdPair = std::pair<transport_router::VertexId, transport_router::VertexId>;
+
+struct StopIdPairHasher {
+    size_t operator()(const StopIdPair& ids) const {
+        return ids.first * 3571 + ids.second;
+    }
+};
+
+// Formatted Route answers (without request id) by router ids of their stops
+using RouteCache = cache::LruCache<StopIdPair, RouteInfo, StopIdPairHasher>;
+
+class DistanceComputer {
+public:
+    DistanceComputer(const TransportCatalogue& catalogue) : catalogue_(catalogue) {}
+
+    int ComputeDistance(std::string_view from, std::string_view to) const {
+        return catalogue_.GetDistance(from, to);
+    }
+private:
+    const TransportCatalogue& catalogue_;
+};
+
 class StatRequestHandler : public RequestHandler {
 public:
     StatRequestHandler(TransportCatalogue& catalogue,
                        RequestPrinter& printer,
                        MapRenderer& renderer) : RequestHandler(catalogue),
                                                 printer_(printer),
-                                                map_renderer_(renderer) {}
+                                                map_renderer_(renderer),
+                                                distance_computer_(catalogue) {}
 
     void Process(StopInfoRequest&);
     void Process(BusInfoRequest&);
     void Process(MapInfoRequest&);
     void Process(RoutingInfoRequest&);
+    void Process(DirectBusesRequest&);
+    void Process(NearbyRequest&);
+    void Process(SuggestRequest&);
+
+    void Plan(RoutingInfoRequest&);
 
     void ProcessRequests(RequestReader& reader);
     void ProcessRequests(std::vector<std::unique_ptr<StatRequest>>& requests);
 
     void SetCustomRouter(std::unique_ptr<transport_router::RouterBase>&& router) {
         router_ = std::move(router);
+        route_cache_.Clear();
+    }
+
+    RouteCache::Stats GetRouteCacheStats() const {
+        return route_cache_.GetStats();
     }
 
+    // Number of formatted Route answers kept between requests and batches
+    static const size_t ROUTE_CACHE_CAPACITY = 4096;
+
 private:
-    const MapData& GetMapData() const;
+    // Built on the first use, the catalogue isn't changed while requests are processed
+    const MapData& GetMapData();
+
+    transport_router::RouterBase& GetRouter();
+
+    RouteInfo GetRouteInfo(std::string_view from, std::string_view to);
+
+    RouteInfo MakeRouteInfo(const transport_router::RouterItems& route_items, int wait_time);
+
+    // Answers all planned routes with one router call per origin. Routes are planned only
+    // for routers batching them, others would search every route anyway.
+    void FindPlannedRoutes();
+
+    struct PlannedOrigin {
+        std::string_view name;
+        std::vector<std::string_view> destinations;
+        std::vector<transport_router::VertexId> destination_ids;
+    };
 
     RequestPrinter& printer_;
     MapRenderer& map_renderer_;
+    // Routers keep a reference to it and compute distances again when a bus is updated
+    DistanceComputer distance_computer_;
     RoutingSettings routing_settings_;
+    std::optional<MapData> map_data_;
     std::unique_ptr<transport_router::RouterBase> router_;
+    RouteCache route_cache_{ROUTE_CACHE_CAPACITY};
+    std::unordered_map<transport_router::VertexId, PlannedOrigin> planned_origins_;
+    std::unordered_map<StopIdPair, RouteInfo, StopIdPairHasher> planned_routes_;
 };
 
 struct AddingStopRequest : BaseRequest {
@@ -351,32 +501,70 @@ struct MapInfoRequest : StatRequest{
 struct RoutingInfoRequest : StatRequest {
     std::string_view stop_from;
     std::string_view stop_to;
+    // Override routing settings of the base for this request only
+    std::optional<int> wait_time;
+    std::optional<double> bus_velocity;
+    // If set, all routes Pareto-optimal on time and transfers are answered
+    std::optional<int> max_transfers;
 
     void ProcessMeBy(StatRequestHandler& handler) override {
         handler.Process(*this);
     }
 
+    void PlanMeBy(StatRequestHandler& handler) override {
+        handler.Plan(*this);
+    }
+
     ~RoutingInfoRequest() override = default;
 };
 
-class DistanceComputer {
-public:
-    DistanceComputer(const TransportCatalogue& catalogue) : catalogue_(catalogue) {}
+struct DirectBusesRequest : StatRequest {
+    std::string_view stop_from;
+    std::string_view stop_to;
 
-    int ComputeDistance(std::string_view from, std::string_view to) const {
-        return catalogue_.GetDistance(from, to);
+    void ProcessMeBy(StatRequestHandler& handler) override {
+        handler.Process(*this);
     }
-private:
-    const TransportCatalogue& catalogue_;
+
+    ~DirectBusesRequest() override = default;
+};
+
+struct NearbyRequest : StatRequest {
+    geo::Coordinates center;
+    // At least one of them is set
+    std::optional<int> count;
+    std::optional<double> radius;
+
+    void ProcessMeBy(StatRequestHandler& handler) override {
+        handler.Process(*this);
+    }
+
+    ~NearbyRequest() override = default;
+};
+
+struct SuggestRequest : StatRequest {
+    static const size_t DEFAULT_COUNT = 10;
+
+    std::string_view prefix;
+    size_t count = DEFAULT_COUNT;
+
+    void ProcessMeBy(StatRequestHandler& handler) override {
+        handler.Process(*this);
+    }
+
+    ~SuggestRequest() override = default;
 };
 
 class CatalogueSerializationHandler {
 public:
-    CatalogueSerializationHandler(const SerializationSettings& settings) : file_(settings.file) {}
+    CatalogueSerializationHandler(const SerializationSettings& settings)
+        : file_(settings.file),
+          previous_file_(settings.previous_file) {}
 
     void Serialize(RequestReader& reader, MapRenderer& renderer);
 private:
     std::string file_;
+    std::optional<std::string> previous_file_;
 };
 
 class CatalogueDeserializationHandler {
@@ -0,0 +1,57 @@
+#include "router_customization.h"
+
+#include "shortest_paths.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace transport_router {
+
+graph::EdgeId RouterCustomization::AddEdge(graph::VertexId from, graph::VertexId to, int64_t distance) {
+    customizations_.Clear();
+    return topology_.AddEdge({from, to, static_cast<double>(distance)});
+}
+
+void RouterCustomization::SetDistance(graph::EdgeId edge_id, int64_t distance) {
+    customizations_.Clear();
+    topology_.SetEdgeWeight(edge_id, static_cast<double>(distance));
+}
+
+double RouterCustomization::ComputeWeight(int64_t distance, const RoutingMetric& metric) {
+    const double MINS_IN_HOUR = 60;
+    const double METERS_IN_KM = 1000;
+
+    return metric.wait_time + (distance / METERS_IN_KM / metric.bus_velocity) * MINS_IN_HOUR;
+}
+
+double RouterCustomization::GetWeight(graph::EdgeId edge_id, const RoutingMetric& metric) const {
+    return ComputeWeight(static_cast<int64_t>(topology_.GetEdge(edge_id).weight), metric);
+}
+
+std::shared_ptr<const RouterCustomization::Graph> RouterCustomization::Customize(const RoutingMetric& metric) {
+    if (const auto* cached = customizations_.Find(metric)) {
+        return *cached;
+    }
+    if (!(metric.bus_velocity > 0) || metric.wait_time < 0) {
+        throw std::invalid_argument("RouterCustomization: velocity should be positive and wait time non-negative\n");
+    }
+
+    auto result = std::make_shared<Graph>(topology_);
+    for (graph::EdgeId edge_id = 0; edge_id < result->GetEdgeCount(); ++edge_id) {
+        result->SetEdgeWeight(edge_id, GetWeight(edge_id, metric));
+    }
+    customizations_.Insert(metric, result);
+    return result;
+}
+
+std::optional<RouterCustomization::RouteInfo>
+RouterCustomization::FindRoute(graph::VertexId from, graph::VertexId to, const RoutingMetric& metric) {
+    const std::shared_ptr<const Graph> customized = Customize(metric);
+    auto route = graph::ShortestPathsTree<double>(*customized, from).BuildRoute(to);
+    if (!route) {
+        return std::nullopt;
+    }
+    return RouteInfo{route->weight, std::move(route->edges)};
+}
+
+} // namespace transport_router
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "graph.h"
+#include "lru_cache.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace transport_router {
+
+// Routing settings edge weights are computed from
+struct RoutingMetric {
+    int wait_time;
+    double bus_velocity;
+
+    bool operator==(const RoutingMetric& other) const {
+        return wait_time == other.wait_time && bus_velocity == other.bus_velocity;
+    }
+};
+
+struct RoutingMetricHasher {
+    size_t operator()(const RoutingMetric& metric) const {
+        return std::hash<int>{}(metric.wait_time) * 37 + std::hash<double>{}(metric.bus_velocity);
+    }
+};
+
+// Metric-independent part of a router graph: ends and road length of every edge. It is built
+// once, and a customization turns it into weights of other settings in O(E), with nothing else
+// recomputed. The edge kept for a pair of stops doesn't depend on settings: every edge has
+// one wait, so the shortest road gives the lightest edge for all of them.
+class RouterCustomization {
+public:
+    using Graph = graph::DirectedWeightedGraph<double>;
+
+    struct RouteInfo {
+        double weight;
+        std::vector<graph::EdgeId> edges;
+    };
+
+    // Number of customized graphs kept for recent settings
+    static const size_t CUSTOMIZATIONS_CAPACITY = 4;
+
+    RouterCustomization() = default;
+
+    explicit RouterCustomization(size_t vertex_count) : topology_(vertex_count) {}
+
+    // Edges should be added in the order of the router graph ones, so their ids match
+    graph::EdgeId AddEdge(graph::VertexId from, graph::VertexId to, int64_t distance);
+
+    void SetDistance(graph::EdgeId edge_id, int64_t distance);
+
+    size_t GetVertexCount() const {
+        return topology_.GetVertexCount();
+    }
+
+    // Bus ride along the road plus one wait, in minutes
+    static double ComputeWeight(int64_t distance, const RoutingMetric& metric);
+
+    double GetWeight(graph::EdgeId edge_id, const RoutingMetric& metric) const;
+
+    // Graph of the same edges weighted for the metric
+    std::shared_ptr<const Graph> Customize(const RoutingMetric& metric);
+
+    std::optional<RouteInfo> FindRoute(graph::VertexId from, graph::VertexId to, const RoutingMetric& metric);
+
+private:
+    // Weights are road lengths in meters
+    Graph topology_;
+    cache::LruCache<RoutingMetric, std::shared_ptr<const Graph>, RoutingMetricHasher>
+        customizations_{CUSTOMIZATIONS_CAPACITY};
+};
+
+} // namespace transport_router
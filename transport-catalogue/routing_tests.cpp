@@ -0,0 +1,325 @@
+// Checks stay on in release builds
+#undef NDEBUG
+
+#include "unit_tests.h"
+#include "graph.h"
+#include "shortest_paths.h"
+#include "batched_paths.h"
+#include "landmarks.h"
+#include "hub_labels.h"
+#include "pareto_routes.h"
+#include "transport_router.h"
+#include "transport_catalogue.h"
+#include "request_handler.h"
+#include "test_network.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tests {
+
+namespace {
+
+using Graph = graph::DirectedWeightedGraph<double>;
+
+// Integer weights, so sums along different paths compare exactly. Some vertexes are left
+// out of the edges, so some pairs have no path.
+Graph MakeTestGraph(uint32_t seed, size_t vertex_count, size_t edge_count) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<size_t> vertexes(0, vertex_count * 9 / 10);
+    std::uniform_int_distribution<int> weights(1, 20);
+    Graph result(vertex_count);
+    for (size_t i = 0; i < edge_count; ++i) {
+        result.AddEdge({vertexes(generator), vertexes(generator), static_cast<double>(weights(generator))});
+    }
+    return result;
+}
+
+// The route is a path from one vertex to the other of the expected weight
+template <typename RouteInfo>
+void CheckRoute(const Graph& graph, graph::VertexId from, graph::VertexId to,
+                const std::optional<RouteInfo>& route, const std::optional<double>& expected) {
+    assert(route.has_value() == expected.has_value());
+    if (!route) {
+        return;
+    }
+    assert(static_cast<double>(route->weight) == *expected);
+    graph::VertexId vertex = from;
+    double weight = 0;
+    for (graph::EdgeId edge_id : route->edges) {
+        const graph::Edge<double>& edge = graph.GetEdge(edge_id);
+        assert(edge.from == vertex);
+        vertex = edge.to;
+        weight += edge.weight;
+    }
+    assert(vertex == to);
+    assert(weight == *expected);
+}
+
+// Unsigned weights are searched with a radix heap instead of a binary one
+void TestIntegerWeightsMatchDoubles() {
+    for (uint32_t seed = 0; seed < 5; ++seed) {
+        const Graph graph = MakeTestGraph(seed, 60, 200);
+        graph::DirectedWeightedGraph<uint64_t> integer_graph(graph.GetVertexCount());
+        for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const graph::Edge<double>& edge = graph.GetEdge(edge_id);
+            integer_graph.AddEdge({edge.from, edge.to, static_cast<uint64_t>(edge.weight)});
+        }
+
+        for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            const graph::ShortestPathsTree<double> tree(graph, from);
+            const graph::ShortestPathsTree<uint64_t> integer_tree(integer_graph, from);
+            for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                const std::optional<double> expected = tree.GetWeight(to);
+                const std::optional<uint64_t> weight = integer_tree.GetWeight(to);
+                assert(weight.has_value() == expected.has_value());
+                assert(!weight || static_cast<double>(*weight) == *expected);
+                CheckRoute(graph, from, to, integer_tree.BuildRoute(to), expected);
+            }
+        }
+    }
+}
+
+// Routes are chosen over rounded weights, but their totals are the sums of exact item times
+void TestQuantizedRouteTotals() {
+    const TestNetwork network = MakeTestNetwork(4, 30, 12);
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue, network);
+
+    request_handler::RoutingSettings settings;
+    settings.bus_velocity = 40;
+    settings.wait_time = 6;
+    settings.time_units_per_minute = 1;
+    const request_handler::DistanceComputer distance_computer(catalogue);
+    transport_router::TransportRouter router(settings, distance_computer,
+                                             {catalogue.GetStopsUsed(), catalogue.GetBusesForRender()});
+    const transport_router::TransportRouter::EdgesStats stats = router.GetEdgesStats();
+    assert(0 < stats.kept && stats.kept <= stats.generated);
+    for (const TestStop& from : network.stops) {
+        for (const TestStop& to : network.stops) {
+            const transport_router::RouterItems route = router.FindRoute(from.name, to.name);
+            double time = 0;
+            for (const transport_router::RouterItem& item : route.items) {
+                time += item.time;
+            }
+            assert(route.total_time < 0 || route.total_time == time);
+        }
+    }
+}
+
+// Batches of sources, the last one not full
+void TestBatchedPathsMatchDijkstra() {
+    using BatchedPaths = graph::BatchedShortestPaths<double>;
+    for (uint32_t seed = 0; seed < 5; ++seed) {
+        const Graph graph = MakeTestGraph(seed, 60, 200);
+        const BatchedPaths paths(graph);
+
+        const size_t batch_size = BatchedPaths::LANES_NUMBER - 1;
+        for (graph::VertexId begin = 0; begin < graph.GetVertexCount(); begin += batch_size) {
+            std::vector<graph::VertexId> sources;
+            const graph::VertexId end = std::min(graph.GetVertexCount(), begin + batch_size);
+            for (graph::VertexId from = begin; from < end; ++from) {
+                sources.push_back(from);
+            }
+            const BatchedPaths::Trees trees = paths.Search(sources);
+            assert(trees.GetSourcesCount() == sources.size());
+            for (size_t lane = 0; lane < sources.size(); ++lane) {
+                const graph::ShortestPathsTree<double> tree(graph, sources[lane]);
+                for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                    const std::optional<double> expected = tree.GetWeight(to);
+                    assert(trees.GetWeight(lane, to) == expected);
+                    CheckRoute(graph, sources[lane], to, trees.BuildRoute(lane, to), expected);
+                }
+            }
+        }
+    }
+}
+
+void TestLandmarksMatchDijkstra() {
+    for (uint32_t seed = 0; seed < 5; ++seed) {
+        const Graph graph = MakeTestGraph(seed, 60, 200);
+        const graph::Landmarks<double> landmarks(graph, 4);
+        // As read from a base
+        const graph::Landmarks<double> copy(landmarks.GetVertexes(), landmarks.GetDistancesTo(),
+                                            landmarks.GetDistancesFrom());
+
+        for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            const graph::ShortestPathsTree<double> tree(graph, from);
+            for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                const std::optional<double> expected = tree.GetWeight(to);
+                assert(landmarks.GetLowerBound(from, to) <= expected.value_or(graph::Landmarks<double>::UNREACHABLE));
+                CheckRoute(graph, from, to, landmarks.FindRoute(graph, from, to), expected);
+                CheckRoute(graph, from, to, copy.FindRoute(graph, from, to), expected);
+            }
+        }
+    }
+}
+
+void TestHubLabelsMatchDijkstra() {
+    for (uint32_t seed = 0; seed < 5; ++seed) {
+        const Graph graph = MakeTestGraph(seed, 60, 200);
+        const graph::HubLabels<double> labels(graph);
+        // As read from a base
+        const graph::HubLabels<double> copy(labels.GetOrder(), labels.GetForwardLabels(), labels.GetBackwardLabels());
+
+        for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            const graph::ShortestPathsTree<double> tree(graph, from);
+            for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                const std::optional<double> expected = tree.GetWeight(to);
+                assert(labels.GetWeight(from, to) == expected);
+                CheckRoute(graph, from, to, labels.BuildRoute(graph, from, to), expected);
+                CheckRoute(graph, from, to, copy.BuildRoute(graph, from, to), expected);
+            }
+        }
+    }
+}
+
+// Lightest weights of walks of at most k edges for every k, by plain Bellman-Ford rounds
+std::vector<std::vector<double>> GetBoundedWeights(const Graph& graph, graph::VertexId from, size_t max_edges) {
+    const double unreached = std::numeric_limits<double>::infinity();
+    std::vector<std::vector<double>> result(max_edges + 1, std::vector<double>(graph.GetVertexCount(), unreached));
+    result[0][from] = 0;
+    for (size_t k = 1; k <= max_edges; ++k) {
+        result[k] = result[k - 1];
+        for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const graph::Edge<double>& edge = graph.GetEdge(edge_id);
+            result[k][edge.to] = std::min(result[k][edge.to], result[k - 1][edge.from] + edge.weight);
+        }
+    }
+    return result;
+}
+
+void TestParetoRoutesMatchBoundedSearch() {
+    const size_t max_edges = 5;
+    for (uint32_t seed = 0; seed < 5; ++seed) {
+        const Graph graph = MakeTestGraph(seed, 40, 120);
+        for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            const std::vector<std::vector<double>> weights = GetBoundedWeights(graph, from, max_edges);
+            for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                if (from == to) {
+                    continue;
+                }
+                // Numbers of edges at which the lightest weight gets strictly lighter
+                std::vector<std::pair<size_t, double>> expected;
+                for (size_t k = 1; k <= max_edges; ++k) {
+                    if (weights[k][to] < weights[k - 1][to]) {
+                        expected.push_back({k, weights[k][to]});
+                    }
+                }
+
+                const std::vector<graph::ParetoRoute<double>> routes
+                        = graph::FindParetoRoutes(graph, from, to, max_edges);
+                assert(routes.size() == expected.size());
+                for (size_t i = 0; i < routes.size(); ++i) {
+                    assert(routes[i].edges.size() == expected[i].first);
+                    CheckRoute(graph, from, to, std::optional<graph::ParetoRoute<double>>(routes[i]),
+                               std::optional<double>(expected[i].second));
+                }
+            }
+        }
+    }
+}
+
+std::vector<double> GetRouteTimes(transport_router::TransportRouter& router, const TestNetwork& network) {
+    std::vector<double> result;
+    for (const TestStop& from : network.stops) {
+        for (const TestStop& to : network.stops) {
+            result.push_back(router.FindRoute(from.name, to.name).total_time);
+        }
+    }
+    return result;
+}
+
+void CheckSameTimes(const std::vector<double>& lhs, const std::vector<double>& rhs) {
+    assert(lhs.size() == rhs.size());
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        assert(std::abs(lhs[i] - rhs[i]) <= 1e-9 * std::max(1.0, std::abs(lhs[i])));
+    }
+}
+
+void TestUpdateBusMatchesRebuild() {
+    const TestNetwork network = MakeTestNetwork(3, 30, 12);
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue, network);
+
+    request_handler::RoutingSettings settings;
+    settings.bus_velocity = 40;
+    settings.wait_time = 6;
+    const request_handler::DistanceComputer distance_computer(catalogue);
+    transport_router::TransportRouter router(settings, distance_computer,
+                                             {catalogue.GetStopsUsed(), catalogue.GetBusesForRender()}, true);
+    // Trees cached before the updates should be dropped where they change
+    GetRouteTimes(router, network);
+
+    std::mt19937 generator(3);
+    for (int update = 0; update < 10; ++update) {
+        const TestBus& bus = network.buses[update % network.buses.size()];
+        const size_t index = std::uniform_int_distribution<size_t>(1, bus.stops.size() - 1)(generator);
+        const std::string& from = bus.stops[index - 1];
+        const std::string& to = bus.stops[index];
+        catalogue.AddDistance(from, to, update % 2 == 0 ? catalogue.GetDistance(from, to) * 3
+                                                        : std::max(1, catalogue.GetDistance(from, to) / 4));
+        for (const domain::Bus* other : catalogue.GetBusesForRender()) {
+            const domain::RouteView<domain::Stop*> stops = other->GetRoute();
+            for (size_t i = 1; i < stops.size(); ++i) {
+                if ((stops[i - 1]->name == from && stops[i]->name == to)
+                    || (stops[i - 1]->name == to && stops[i]->name == from)) {
+                    router.UpdateBus(*other);
+                    break;
+                }
+            }
+        }
+
+        transport_router::TransportRouter rebuilt(settings, distance_computer,
+                                                  {catalogue.GetStopsUsed(), catalogue.GetBusesForRender()});
+        CheckSameTimes(GetRouteTimes(router, network), GetRouteTimes(rebuilt, network));
+    }
+
+    // A new bus over stops the router knows, with new roads between them
+    const std::vector<std::string_view> new_stops{network.buses[0].stops.front(), network.buses[1].stops.front(),
+                                                  network.buses[2].stops.front()};
+    for (size_t i = 1; i < new_stops.size(); ++i) {
+        catalogue.AddDistance(new_stops[i - 1], new_stops[i], 100);
+    }
+    catalogue.AddBus({"new", new_stops, false});
+    for (const domain::Bus* bus : catalogue.GetBusesForRender()) {
+        if (bus->name == "new") {
+            router.UpdateBus(*bus);
+        }
+    }
+    transport_router::TransportRouter rebuilt(settings, distance_computer,
+                                              {catalogue.GetStopsUsed(), catalogue.GetBusesForRender()});
+    CheckSameTimes(GetRouteTimes(router, network), GetRouteTimes(rebuilt, network));
+
+    // Routers built without updates keep no candidates for them
+    bool thrown = false;
+    try {
+        rebuilt.UpdateBus(**catalogue.GetBusesForRender().begin());
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+} //namespace
+
+void TestRouting() {
+    TestIntegerWeightsMatchDoubles();
+    TestQuantizedRouteTotals();
+    TestBatchedPathsMatchDijkstra();
+    TestLandmarksMatchDijkstra();
+    TestHubLabelsMatchDijkstra();
+    TestParetoRoutesMatchBoundedSearch();
+    TestUpdateBusMatchesRebuild();
+}
+
+} //namespace tests
@@ -5,40 +5,63 @@
 
 #include <string_view>
 #include <vector>
-#include <unordered_map>
 #include <fstream>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 
 #include <transport_catalogue.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
 
 namespace serialization {
 
+google::protobuf::ArenaOptions MakeArenaOptions() {
+    google::protobuf::ArenaOptions options;
+    options.start_block_size = 64 * 1024;
+    options.max_block_size   = 1024 * 1024;
+    return options;
+}
+
 //==========================Serializator==========================================
 
 void CatalogueSerializator::Serialize(const SerializationData& data) {
     FillStops(data.stops);
     FillDistances(data.distances);
     FillBuses(data.buses);
+    FillNamesOrder(data.stops_by_name, data.buses_by_name);
     FillRenderSettings(data.render_settings);
     FillStopPoints(data.stop_points);
-    FillRouterVertexIds(data.router_data.stop_vertexes);
-    FillRouterEdges(data.router_data.edges);
-    FillRoutes(data.router_data.data);
+    FillRouterVertexIds(data.router_data.stop_vertexes, data.router_data.components);
+    FillRouterEdges(data.router_data.edges, data.router_data.graph);
     FillRoutingSettings(data.router_data.wait_time, data.router_data.bus_velocity);
+    if (data.router_data.landmarks) {
+        FillLandmarks(*data.router_data.landmarks);
+    }
+    if (data.router_data.hub_labels) {
+        FillHubLabels(*data.router_data.hub_labels);
+    }
 
     std::ofstream out(file_, std::ios::binary);
-    pb_catalogue_.SerializeToOstream(&out);
+    google::protobuf::io::OstreamOutputStream zero_copy_out(&out);
+    google::protobuf::io::CodedOutputStream coded_out(&zero_copy_out);
+
+    pb_catalogue_.SerializeToCodedStream(&coded_out);
+    if (!data.router_data.landmarks && !data.router_data.hub_labels) {
+        WriteRoutes(data.router_data, coded_out);
+    }
 }
 
 void CatalogueSerializator::FillStops(const std::vector<const domain::Stop*>& stops) {
     using namespace transport_catalogue_serialize;
     for (const domain::Stop* stop : stops) {
-        const std::string& name = stop->name;
+        std::string_view name = stop->name;
         uint32_t id = GetStopId(name);
         double latitude  = stop->coordinates.lat;
         double longitude = stop->coordinates.lng;
 
         Stop& pb_stop = *pb_catalogue_.add_stops();
-        pb_stop.set_name(name);
+        pb_stop.set_name(name.data(), name.size());
         pb_stop.set_id(id);
         pb_stop.set_latitude(latitude);
         pb_stop.set_longitude(longitude);
@@ -50,17 +73,15 @@ void CatalogueSerializator::FillBuses(const std::vector<const domain::Bus*>& bus
     using namespace transport_catalogue_serialize;
 
     for (const domain::Bus* bus : buses) {
-        const std::string& name = bus->name;
+        std::string_view name = bus->name;
         bool is_roundtrip = bus->is_roundtrip;
         Bus& pb_bus = *pb_catalogue_.add_buses();
-        pb_bus.set_name(name);
+        pb_bus.set_name(name.data(), name.size());
         pb_bus.set_is_roundtrip(is_roundtrip);
         pb_bus.set_id(GetBusId(name));
 
-        int stop_number = is_roundtrip ? bus->stops.size() : (bus->stops.size() / 2 + 1);
-
-        for (int i = 0; i < stop_number; ++i) {
-            const domain::Stop* stop = bus->stops[i];
+        // Non-roundtrip buses are stored one way, as in the catalogue
+        for (const domain::Stop* stop : bus->stops) {
             pb_bus.add_stops(stops_ids_.at(stop->name));
         }
 
@@ -84,6 +105,12 @@ void CatalogueSerializator::FillDistances(const std::vector<distance_t>& distanc
     }
 }
 
+void CatalogueSerializator::FillNamesOrder(const std::vector<uint32_t>& stops_by_name,
+                                           const std::vector<uint32_t>& buses_by_name) {
+    pb_catalogue_.mutable_stops_by_name()->Add(stops_by_name.begin(), stops_by_name.end());
+    pb_catalogue_.mutable_buses_by_name()->Add(buses_by_name.begin(), buses_by_name.end());
+}
+
 void CatalogueSerializator::FillRenderSettings(const request_handler::RenderSettings& render_settings) {
     auto& pb_settings = *pb_catalogue_.mutable_map_renderer()->mutable_settings();
     pb_settings.set_stop_label_font_size(render_settings.stop_label_font_size);
@@ -116,7 +143,8 @@ void CatalogueSerializator::FillStopPoints(const std::map<std::string_view, doma
     }
 }
 
-void CatalogueSerializator::FillRouterVertexIds(const std::unordered_map<std::string_view, size_t>& stop_vertexes) {
+void CatalogueSerializator::FillRouterVertexIds(const container::FlatHashMap<std::string_view, size_t>& stop_vertexes,
+                                                const std::vector<uint32_t>& components) {
     using namespace transport_catalogue_serialize;
     RouterData& pb_data = *pb_catalogue_.mutable_router_data();
 
@@ -125,87 +153,179 @@ void CatalogueSerializator::FillRouterVertexIds(const std::unordered_map<std::st
         stops_router_ids_[name] = id;
         pb_vertex_id.set_router_id(id);
         pb_vertex_id.set_catalogue_id(stops_ids_.at(name));
+        pb_vertex_id.set_component_id(components.at(id));
     }
 }
 
-void CatalogueSerializator::FillRouterEdges(const std::vector<transport_router::RouterItem>& edges) {
+void CatalogueSerializator::FillRouterEdges(const std::vector<transport_router::RouterItem>& edges,
+                                            const graph::DirectedWeightedGraph<double>& graph) {
     using namespace transport_catalogue_serialize;
     RouterData& pb_data = *pb_catalogue_.mutable_router_data();
 
-    int index = 0;
-
-    for (const transport_router::RouterItem& item : edges) {
+    for (size_t index = 0; index < edges.size(); ++index) {
+        const transport_router::RouterItem& item = edges[index];
         Edge& pb_edge = *pb_data.add_edges();
-        pb_edge.set_edge_id(index++);
+        pb_edge.set_edge_id(index);
         pb_edge.set_stop_id(stops_router_ids_.at(item.start));
+        pb_edge.set_to_id(graph.GetEdge(index).to);
         pb_edge.set_bus_id(buses_ids_.at(item.name));
         pb_edge.set_time(item.time);
         pb_edge.set_count(item.count);
+        pb_edge.set_distance(item.distance);
     }
 }
 
-void CatalogueSerializator::FillRoutes(const std::unordered_map<size_t, transport_router::StopRoutes>& data) {
+void CatalogueSerializator::FillRoutingSettings(int wait_time, double bus_velocity) {
     using namespace transport_catalogue_serialize;
     RouterData& pb_data = *pb_catalogue_.mutable_router_data();
-
-    for (auto& [from_id, routes] : data) {
-        *pb_data.add_stop_route() = ConvertStopsRoutes(routes, from_id);
-    }
+    pb_data.set_bus_velocity(bus_velocity);
+    pb_data.set_wait_time(wait_time);
 }
 
+void CatalogueSerializator::FillLandmarks(const graph::Landmarks<double>& landmarks) {
+    using namespace transport_catalogue_serialize;
+    Landmarks& pb_landmarks = *pb_catalogue_.mutable_router_data()->mutable_landmarks();
 
-void CatalogueSerializator::FillRoutingSettings(int wait_time, double bus_velocity) {
+    pb_landmarks.mutable_vertex_id()->Add(landmarks.GetVertexes().begin(), landmarks.GetVertexes().end());
+    pb_landmarks.mutable_distance_to()->Add(landmarks.GetDistancesTo().begin(), landmarks.GetDistancesTo().end());
+    pb_landmarks.mutable_distance_from()->Add(landmarks.GetDistancesFrom().begin(), landmarks.GetDistancesFrom().end());
+}
+
+void CatalogueSerializator::FillHubLabels(const graph::HubLabels<double>& hub_labels) {
     using namespace transport_catalogue_serialize;
-    RouterData& pb_data = *pb_catalogue_.mutable_router_data();
-    pb_data.set_bus_velocity(bus_velocity);
-    pb_data.set_wait_time(wait_time);
+    HubLabels& pb_hub_labels = *pb_catalogue_.mutable_router_data()->mutable_hub_labels();
+
+    pb_hub_labels.mutable_order()->Add(hub_labels.GetOrder().begin(), hub_labels.GetOrder().end());
+
+    auto fill_labels = [](const graph::HubLabels<double>::Labels& labels, Labels& pb_labels) {
+        pb_labels.mutable_begin()->Add(labels.begins.begin(), labels.begins.end());
+        pb_labels.mutable_hub()->Add(labels.hubs.begin(), labels.hubs.end());
+        pb_labels.mutable_weight()->Add(labels.weights.begin(), labels.weights.end());
+        pb_labels.mutable_edge_id()->Add(labels.edges.begin(), labels.edges.end());
+    };
+    fill_labels(hub_labels.GetForwardLabels(), *pb_hub_labels.mutable_forward());
+    fill_labels(hub_labels.GetBackwardLabels(), *pb_hub_labels.mutable_backward());
+}
+
+// Source rows are independent, so they are converted and encoded concurrently in windows of
+// ROWS_PER_THREAD rows per thread. Threads take rows by batches of ROWS_PER_BATCH consecutive
+// sources. Encoded rows are written in source order, which keeps the file identical to the
+// one written by a single thread.
+void CatalogueSerializator::WriteRoutes(const transport_router::RouterSerializationData& router_data,
+                                        google::protobuf::io::CodedOutputStream& out) const {
+    const size_t vertex_count = router_data.stop_vertexes.size();
+    const size_t threads_number = std::max(1u, std::thread::hardware_concurrency());
+    const size_t window_size = threads_number * ROWS_PER_THREAD;
+
+    std::vector<std::string> encoded_rows(std::min(window_size, vertex_count));
+
+    for (size_t window_begin = 0; window_begin < vertex_count; window_begin += window_size) {
+        const size_t window_end = std::min(vertex_count, window_begin + window_size);
+        std::atomic<size_t> next_row = window_begin;
+
+        auto encode_rows = [&]() {
+            using transport_catalogue_serialize::StopRoutes;
+            google::protobuf::Arena arena(MakeArenaOptions());
+            for (size_t batch_begin = next_row.fetch_add(ROWS_PER_BATCH);
+                 batch_begin < window_end;
+                 batch_begin = next_row.fetch_add(ROWS_PER_BATCH))
+            {
+                const size_t batch_end = std::min(window_end, batch_begin + ROWS_PER_BATCH);
+                std::vector<transport_router::StopRoutes> rows = router_data.make_stops_routes(batch_begin, batch_end);
+                for (size_t from_id = batch_begin; from_id < batch_end; ++from_id) {
+                    StopRoutes& pb_routes = *google::protobuf::Arena::CreateMessage<StopRoutes>(&arena);
+                    FillStopRoutes(rows[from_id - batch_begin], from_id, pb_routes);
+                    encoded_rows[from_id - window_begin] = EncodeStopRoutes(pb_routes);
+                    arena.Reset();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads_number && i < window_end - window_begin; ++i) {
+            workers.emplace_back(encode_rows);
+        }
+        encode_rows();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        for (size_t from_id = window_begin; from_id < window_end; ++from_id) {
+            const std::string& row = encoded_rows[from_id - window_begin];
+            out.WriteRaw(row.data(), row.size());
+        }
+    }
+}
+
+// Every row is written as a separate TransportCatalogue.router_data message holding one
+// stop_route. The parser merges repeated occurrences of a message field, so the file reads
+// back as a single TransportCatalogue while only a few rows are kept in memory at a time.
+std::string CatalogueSerializator::EncodeStopRoutes(const transport_catalogue_serialize::StopRoutes& stop_routes) {
+    namespace pb = transport_catalogue_serialize;
+    using google::protobuf::io::CodedOutputStream;
+    const uint32_t LENGTH_DELIMITED = 2;
+    const uint32_t router_data_tag = (pb::TransportCatalogue::kRouterDataFieldNumber << 3) | LENGTH_DELIMITED;
+    const uint32_t stop_route_tag  = (pb::RouterData::kStopRouteFieldNumber << 3) | LENGTH_DELIMITED;
+
+    const uint32_t stop_routes_size = stop_routes.ByteSizeLong();
+    const uint32_t router_data_size = CodedOutputStream::VarintSize32(stop_route_tag)
+                                    + CodedOutputStream::VarintSize32(stop_routes_size)
+                                    + stop_routes_size;
+
+    std::string result;
+    {
+        google::protobuf::io::StringOutputStream zero_copy_out(&result);
+        CodedOutputStream out(&zero_copy_out);
+        out.WriteTag(router_data_tag);
+        out.WriteVarint32(router_data_size);
+        out.WriteTag(stop_route_tag);
+        out.WriteVarint32(stop_routes_size);
+        stop_routes.SerializeWithCachedSizes(&out);
+    }
+    return result;
 }
 
 uint32_t CatalogueSerializator::GetStopId(std::string_view name) {
-    static uint32_t counter = 0;
     auto it = stops_ids_.find(name);
     if (it == stops_ids_.end()) {
-        stops_ids_[name] = counter;
-        return counter++;
+        // Ids are dense in one base
+        const uint32_t id = static_cast<uint32_t>(stops_ids_.size());
+        stops_ids_[name] = id;
+        return id;
     } else {
         return it->second;
     }
 }
 
 uint32_t CatalogueSerializator::GetBusId(std::string_view name) {
-    static uint32_t counter = 0;
     auto it = buses_ids_.find(name);
     if (it == buses_ids_.end()) {
-        buses_ids_[name] = counter;
-        return counter++;
+        // Ids are dense in one base
+        const uint32_t id = static_cast<uint32_t>(buses_ids_.size());
+        buses_ids_[name] = id;
+        return id;
     } else {
         return it->second;
     }
 }
 
-transport_catalogue_serialize::Route
-CatalogueSerializator::ConvertRoute(const transport_router::WholeRoute& route,
-                                    size_t to_vertex_id) {
-    transport_catalogue_serialize::Route result;
-    result.set_to_id(to_vertex_id);
-    result.set_weight(route.time);
+void CatalogueSerializator::FillRoute(const transport_router::WholeRoute& route, size_t to_vertex_id,
+                                      transport_catalogue_serialize::Route& pb_route) {
+    pb_route.set_to_id(to_vertex_id);
+    pb_route.set_weight(route.time);
+    pb_route.mutable_edge_id()->Reserve(route.edges_ids.size());
     for (size_t edge_id : route.edges_ids) {
-        result.add_edge_id(edge_id);
+        pb_route.add_edge_id(edge_id);
     }
-    return result;
 }
 
-transport_catalogue_serialize::StopRoutes
-CatalogueSerializator::ConvertStopsRoutes
-            (const std::unordered_map<size_t, transport_router::WholeRoute>& routes,
-             size_t from_vertex_id)
-{
-    transport_catalogue_serialize::StopRoutes result;
-    result.set_from_id(from_vertex_id);
+void CatalogueSerializator::FillStopRoutes(const transport_router::StopRoutes& routes, size_t from_vertex_id,
+                                           transport_catalogue_serialize::StopRoutes& pb_routes) {
+    pb_routes.set_from_id(from_vertex_id);
+    pb_routes.mutable_route()->Reserve(routes.size());
     for (auto& [to_id, route] : routes) {
-        *result.add_route() = ConvertRoute(route, to_id);
+        FillRoute(route, to_id, *pb_routes.add_route());
     }
-    return result;
 }
 
 transport_catalogue_serialize::Point CatalogueSerializator::ConvertPoint(domain::Point point) {
@@ -244,19 +364,25 @@ transport_catalogue_serialize::Color CatalogueSerializator::ConvertColor(domain:
 DeserializationData CatalogueDeserializator::Deserialize() {
     using namespace transport_catalogue_serialize;
     std::ifstream in(file_, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("CatalogueDeserializator: can't open base \"" + file_ + "\"\n");
+    }
     if (!pb_catalogue_.ParseFromIstream(&in)) {
-        return result_;
+        throw std::runtime_error("CatalogueDeserializator: can't parse base \"" + file_ + "\"\n");
     }
 
     ParseStops();
     ParseBuses();
     ParseDistances();
+    ParseNamesOrder();
     ParseRenderSettings();
     ParseStopPoints();
 
     ParseRouterStops();
     ParseRouterBuses();
     ParseRouterEdges();
+    ParseRouterLandmarks();
+    ParseRouterHubLabels();
     ParseRouterRoutes();
     ParseRouterSettings();
 
@@ -320,6 +446,11 @@ void CatalogueDeserializator::ParseDistances() {
     }
 }
 
+void CatalogueDeserializator::ParseNamesOrder() {
+    result_.stops_by_name.assign(pb_catalogue_.stops_by_name().begin(), pb_catalogue_.stops_by_name().end());
+    result_.buses_by_name.assign(pb_catalogue_.buses_by_name().begin(), pb_catalogue_.buses_by_name().end());
+}
+
 void CatalogueDeserializator::ParseRenderSettings() {
     using namespace transport_catalogue_serialize;
     const RenderSettings& pb_settings = pb_catalogue_.map_renderer().settings();
@@ -358,7 +489,7 @@ void CatalogueDeserializator::ParseStopPoints() {
     for (int i = 0; i < point_number; ++i) {
         const StopPoint& pb_point = pb_map_renderer.stop_point(i);
         domain::Point tmp_point;
-        std::string name = stops_ptrs_.at(pb_point.name())->name;
+        std::string name(stops_ptrs_.at(pb_point.name())->name);
         tmp_point.x = pb_point.coordinates().x();
         tmp_point.y = pb_point.coordinates().y();
         stop_points[name] = tmp_point;
@@ -374,13 +505,17 @@ void CatalogueDeserializator::ParseRouterStops() {
 
     int stops_number = pb_data.stop_ids_size();
     res_stops.reserve(stops_number);
+    std::vector<uint32_t> components(stops_number);
 
     for (int i = 0; i < stops_number; ++i) {
         size_t cat_id  = pb_data.stop_ids(i).catalogue_id();
         size_t rout_id = pb_data.stop_ids(i).router_id();
         std::string_view name = stops_.at(cat_id);
         res_stops.push_back({name, rout_id});
+        components.at(rout_id) = pb_data.stop_ids(i).component_id();
     }
+
+    result_.router_data.pairs_index = graph::ComponentPairsIndex(std::move(components));
 }
 
 void CatalogueDeserializator::ParseRouterBuses() {
@@ -408,31 +543,85 @@ void CatalogueDeserializator::ParseRouterEdges() {
         const Edge& edge = pb_data.edges(i);
         transport_router::DeserializedRouterItem temp;
         temp.start = edge.stop_id();
+        temp.finish = edge.to_id();
         temp.name  = edge.bus_id();
         temp.time  = edge.time();
         temp.count = edge.count();
+        temp.distance = edge.distance();
         res_edges.push_back({edge.edge_id(), temp});
     }
 }
 
+void CatalogueDeserializator::ParseRouterLandmarks() {
+    using namespace transport_catalogue_serialize;
+    const RouterData& pb_data = pb_catalogue_.router_data();
+    if (!pb_data.has_landmarks()) {
+        return;
+    }
+    const Landmarks& pb_landmarks = pb_data.landmarks();
+
+    result_.router_data.landmarks.emplace(
+        std::vector<size_t>(pb_landmarks.vertex_id().begin(), pb_landmarks.vertex_id().end()),
+        std::vector<double>(pb_landmarks.distance_to().begin(), pb_landmarks.distance_to().end()),
+        std::vector<double>(pb_landmarks.distance_from().begin(), pb_landmarks.distance_from().end()));
+}
+
+void CatalogueDeserializator::ParseRouterHubLabels() {
+    using namespace transport_catalogue_serialize;
+    const RouterData& pb_data = pb_catalogue_.router_data();
+    if (!pb_data.has_hub_labels()) {
+        return;
+    }
+    const HubLabels& pb_hub_labels = pb_data.hub_labels();
+
+    auto parse_labels = [](const Labels& pb_labels) {
+        graph::HubLabels<double>::Labels labels;
+        labels.begins.assign(pb_labels.begin().begin(), pb_labels.begin().end());
+        labels.hubs.assign(pb_labels.hub().begin(), pb_labels.hub().end());
+        labels.weights.assign(pb_labels.weight().begin(), pb_labels.weight().end());
+        labels.edges.assign(pb_labels.edge_id().begin(), pb_labels.edge_id().end());
+        return labels;
+    };
+
+    result_.router_data.hub_labels.emplace(
+        std::vector<size_t>(pb_hub_labels.order().begin(), pb_hub_labels.order().end()),
+        parse_labels(pb_hub_labels.forward()),
+        parse_labels(pb_hub_labels.backward()));
+}
+
 void CatalogueDeserializator::ParseRouterRoutes() {
     using namespace transport_catalogue_serialize;
     const RouterData& pb_data = pb_catalogue_.router_data();
-    std::unordered_map<size_t, std::unordered_map<size_t, transport_router::DeserializedRouterItems>>& res_map
-    = result_.router_data.routes;
+    transport_router::LazyRouterData& res_data = result_.router_data;
+    if (res_data.landmarks || res_data.hub_labels) {
+        return;
+    }
+
+    const graph::ComponentPairsIndex& pairs_index = res_data.pairs_index;
+    res_data.routes.assign(pairs_index.GetPairsCount(), {});
 
     int from_stop_number = pb_data.stop_route_size();
 
+    size_t edges_number = 0;
+    for (const StopRoutes& pb_routes : pb_data.stop_route()) {
+        for (const Route& pb_route : pb_routes.route()) {
+            edges_number += pb_route.edge_id_size();
+        }
+    }
+    res_data.route_edges.reserve(edges_number);
+
     for (int i = 0; i < from_stop_number; ++i) {
         const StopRoutes& pb_routes = pb_data.stop_route(i);
-        std::unordered_map<size_t, transport_router::DeserializedRouterItems>& res_route
-        = res_map[pb_routes.from_id()];
 
         int to_stop_number = pb_routes.route_size();
 
         for(int j = 0; j < to_stop_number; ++j) {
             const Route& pb_route = pb_routes.route(j);
-            res_route[pb_route.to_id()] = ConvertItems(pb_route);
+            std::optional<size_t> index = pairs_index.GetIndex(pb_routes.from_id(), pb_route.to_id());
+            if (!index) {
+                throw std::runtime_error("Base has a route between different components\n");
+            }
+            ConvertItems(pb_route, res_data.routes[*index]);
         }
     }
 }
@@ -442,18 +631,15 @@ void CatalogueDeserializator::ParseRouterSettings() {
     result_.router_data.wait_time = pb_catalogue_.router_data().wait_time();
 }
 
-transport_router::DeserializedRouterItems
-CatalogueDeserializator::ConvertItems(const transport_catalogue_serialize::Route& route) {
-    transport_router::DeserializedRouterItems result;
-    result.total_time = route.weight();
+void CatalogueDeserializator::ConvertItems(const transport_catalogue_serialize::Route& route,
+                                           transport_router::RouteSpan& span) {
+    std::vector<uint32_t>& route_edges = result_.router_data.route_edges;
 
-    int edges_number = route.edge_id_size();
+    span.total_time = route.weight();
+    span.begin = route_edges.size();
+    span.size  = route.edge_id_size();
 
-    for (int i = 0; i < edges_number; ++i) {
-        size_t edge_id = route.edge_id(i);
-        result.items.push_back(route.edge_id(i));
-    }
-    return result;
+    route_edges.insert(route_edges.end(), route.edge_id().begin(), route.edge_id().end());
 }
 
 domain::Point CatalogueDeserializator::ConvertPoint(const transport_catalogue_serialize::Point& point) {
@@ -2,13 +2,15 @@
 
 #include "domain.h"
 #include "request_handler.h"
+#include "flat_hash_map.h"
 
 #include <string_view>
 #include <vector>
-#include <unordered_map>
 #include <fstream>
 
 #include <transport_catalogue.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/arena.h>
 
 namespace serialization {
 
@@ -22,6 +24,9 @@ struct SerializationData {
     std::map<std::string_view, domain::Point> stop_points;
     request_handler::RenderSettings render_settings;
     transport_router::RouterSerializationData router_data;
+    // Positions in stops and buses in the order of names
+    std::vector<uint32_t> stops_by_name;
+    std::vector<uint32_t> buses_by_name;
 };
 
 struct DeserializationData {
@@ -31,29 +36,52 @@ struct DeserializationData {
     std::map<std::string, domain::Point> stop_points;
     request_handler::RenderSettings render_settings;
     transport_router::LazyRouterData router_data;
+    // Empty if the base was written without them
+    std::vector<uint32_t> stops_by_name;
+    std::vector<uint32_t> buses_by_name;
 };
 
+// Messages of a base are allocated on an arena: millions of Route and Edge submessages
+// are then created and freed in a few large blocks instead of one malloc each.
+google::protobuf::ArenaOptions MakeArenaOptions();
+
 class CatalogueSerializator {
 public:
-    CatalogueSerializator(std::string file) : file_(std::move(file)) {}
+    // Rows encoded by each thread between two writes, bounds memory used for encoded rows
+    static const size_t ROWS_PER_THREAD = 16;
+    // Rows asked from the router at once, so that it can search from several sources together
+    static const size_t ROWS_PER_BATCH = 8;
+
+    CatalogueSerializator(std::string file)
+        : file_(std::move(file)),
+          arena_(MakeArenaOptions()),
+          pb_catalogue_(*google::protobuf::Arena::CreateMessage<transport_catalogue_serialize::TransportCatalogue>(&arena_)) {}
     void Serialize(const SerializationData& data);
 private:
     void FillStops(const std::vector<const domain::Stop*>& stops);
     void FillBuses(const std::vector<const domain::Bus*>& buses);
     void FillDistances(const std::vector<distance_t>& distances);
+    void FillNamesOrder(const std::vector<uint32_t>& stops_by_name, const std::vector<uint32_t>& buses_by_name);
     void FillRenderSettings(const request_handler::RenderSettings& render_settings);
     void FillStopPoints(const std::map<std::string_view, domain::Point>& stop_points);
-    void FillRouterVertexIds(const std::unordered_map<std::string_view, size_t>& stop_vertexes);
-    void FillRouterEdges(const std::vector<transport_router::RouterItem>& edges);
-    void FillRoutes(const std::unordered_map<size_t, transport_router::StopRoutes>& data);
+    void FillRouterVertexIds(const container::FlatHashMap<std::string_view, size_t>& stop_vertexes,
+                             const std::vector<uint32_t>& components);
+    void FillRouterEdges(const std::vector<transport_router::RouterItem>& edges,
+                         const graph::DirectedWeightedGraph<double>& graph);
     void FillRoutingSettings(int wait_time, double bus_velocity);
+    void FillLandmarks(const graph::Landmarks<double>& landmarks);
+    void FillHubLabels(const graph::HubLabels<double>& hub_labels);
+
+    void WriteRoutes(const transport_router::RouterSerializationData& router_data,
+                     google::protobuf::io::CodedOutputStream& out) const;
+
+    static std::string EncodeStopRoutes(const transport_catalogue_serialize::StopRoutes& stop_routes);
 
-    static transport_catalogue_serialize::StopRoutes
-    ConvertStopsRoutes(const std::unordered_map<size_t, transport_router::WholeRoute>& routes,
-                       size_t from_vertex_id);
+    static void FillStopRoutes(const transport_router::StopRoutes& routes, size_t from_vertex_id,
+                               transport_catalogue_serialize::StopRoutes& pb_routes);
 
-    static transport_catalogue_serialize::Route
-    ConvertRoute(const transport_router::WholeRoute& route, size_t to_vertex_id);
+    static void FillRoute(const transport_router::WholeRoute& route, size_t to_vertex_id,
+                          transport_catalogue_serialize::Route& pb_route);
 
     static transport_catalogue_serialize::Point ConvertPoint(domain::Point point);
     static transport_catalogue_serialize::Color ConvertColor(domain::Color color);
@@ -61,35 +89,42 @@ private:
     uint32_t GetStopId(std::string_view name);
     uint32_t GetBusId(std::string_view name);
 
-    std::unordered_map<std::string_view, uint32_t> stops_ids_;
-    std::unordered_map<std::string_view, uint32_t> stops_router_ids_;
-    std::unordered_map<std::string_view, uint32_t> buses_ids_;
+    container::FlatHashMap<std::string_view, uint32_t> stops_ids_;
+    container::FlatHashMap<std::string_view, uint32_t> stops_router_ids_;
+    container::FlatHashMap<std::string_view, uint32_t> buses_ids_;
 
     std::string file_;
-    transport_catalogue_serialize::TransportCatalogue pb_catalogue_;
+    google::protobuf::Arena arena_;
+    transport_catalogue_serialize::TransportCatalogue& pb_catalogue_;
 };
 
 //==================================================================================================
 
 class CatalogueDeserializator {
 public:
-    CatalogueDeserializator(std::string file) : file_(std::move(file)) {}
+    CatalogueDeserializator(std::string file)
+        : file_(std::move(file)),
+          arena_(MakeArenaOptions()),
+          pb_catalogue_(*google::protobuf::Arena::CreateMessage<transport_catalogue_serialize::TransportCatalogue>(&arena_)) {}
     DeserializationData Deserialize();
 private:
 
     void ParseStops();
     void ParseBuses();
     void ParseDistances();
+    void ParseNamesOrder();
     void ParseRenderSettings();
     void ParseStopPoints();
     void ParseRouterStops();
     void ParseRouterBuses();
     void ParseRouterEdges();
+    void ParseRouterLandmarks();
+    void ParseRouterHubLabels();
     void ParseRouterRoutes();
     void ParseRouterSettings();
 
-    static transport_router::DeserializedRouterItems
-    ConvertItems(const transport_catalogue_serialize::Route& route);
+    void ConvertItems(const transport_catalogue_serialize::Route& route,
+                      transport_router::RouteSpan& span);
 
     static domain::Point ConvertPoint(const transport_catalogue_serialize::Point& point);
     static domain::Color ConvertColor(const transport_catalogue_serialize::Color& color);
@@ -97,11 +132,12 @@ private:
     DeserializationData result_;
 
     std::string file_;
-    transport_catalogue_serialize::TransportCatalogue pb_catalogue_;
-    std::unordered_map<uint32_t, std::string_view> stops_;
-    std::unordered_map<uint32_t, std::string_view> buses_;
+    google::protobuf::Arena arena_;
+    transport_catalogue_serialize::TransportCatalogue& pb_catalogue_;
+    container::FlatHashMap<uint32_t, std::string_view> stops_;
+    container::FlatHashMap<uint32_t, std::string_view> buses_;
 
-    std::unordered_map<uint32_t, domain::Stop*> stops_ptrs_;
+    container::FlatHashMap<uint32_t, domain::Stop*> stops_ptrs_;
 };
 
 } //namespace serialization
@@ -0,0 +1,174 @@
+// Checks stay on in release builds
+#undef NDEBUG
+
+#include "unit_tests.h"
+#include "test_network.h"
+#include "request_handler.h"
+#include "json_reader.h"
+#include "map_renderer.h"
+
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace tests {
+
+namespace {
+
+std::string GetTempFile(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("transport_catalogue_tests_" + name)).string();
+}
+
+json::Dict MakeRoutingSettings() {
+    return json::Dict{{"bus_wait_time", 6}, {"bus_velocity", 40.0}};
+}
+
+void MakeBase(const std::string& requests, const std::optional<std::string>& previous_file) {
+    std::istringstream in(requests);
+    stream_input_json::JSONReader reader(in);
+    reader.Read();
+    request_handler::SerializationSettings settings = reader.GetSerializationSettings();
+    settings.previous_file = previous_file;
+    map_renderer::MapRendererJSON renderer;
+    request_handler::CatalogueSerializationHandler(settings).Serialize(reader, renderer);
+}
+
+std::string ProcessRequests(const std::string& requests) {
+    std::istringstream in(requests);
+    stream_input_json::JSONReader reader(in);
+    reader.Read();
+    std::ostringstream out;
+    stream_input_json::JSONPrinter printer(out);
+    map_renderer::MapRendererJSON renderer;
+    request_handler::CatalogueDeserializationHandler(reader.GetSerializationSettings()).Deserialize(printer, renderer, reader);
+    return out.str();
+}
+
+bool Throws(const std::string& requests, const std::optional<std::string>& previous_file) {
+    try {
+        MakeBase(requests, previous_file);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void TestMissingPreviousBase() {
+    const std::string file = GetTempFile("missing_new.db");
+    std::filesystem::remove(file);
+    const std::string requests = MakeRequestsText(MakeTestNetwork(1, 10, 4), MakeRoutingSettings(), file);
+
+    assert(Throws(requests, GetTempFile("no_such_base.db")));
+    // Nothing is written if the previous base can't be read
+    assert(!std::filesystem::exists(file));
+}
+
+void TestBrokenPreviousBase() {
+    const std::string previous_file = GetTempFile("broken.db");
+    {
+        std::ofstream out(previous_file, std::ios::binary);
+        out << "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff";
+    }
+    const std::string requests = MakeRequestsText(MakeTestNetwork(1, 10, 4), MakeRoutingSettings(),
+                                                  GetTempFile("broken_new.db"));
+
+    assert(Throws(requests, previous_file));
+    std::filesystem::remove(previous_file);
+}
+
+// Some distances and one bus differ from the previous data
+TestNetwork ChangeNetwork(TestNetwork network) {
+    size_t changed = 0;
+    for (TestStop& stop : network.stops) {
+        for (auto& [name, distance] : stop.road_distances) {
+            if (changed++ % 7 == 0) {
+                distance = distance * 3 / 2;
+            }
+        }
+    }
+    TestBus& bus = network.buses.back();
+    bus.stops.insert(bus.stops.begin(), network.stops.front().name);
+    network.stops.front().road_distances.emplace(bus.stops[1], 1000);
+    return network;
+}
+
+void TestUpdateMatchesRebuild() {
+    const TestNetwork previous = MakeTestNetwork(2, 40, 14);
+    const TestNetwork current = ChangeNetwork(previous);
+
+    const std::string previous_file = GetTempFile("previous.db");
+    const std::string updated_file = GetTempFile("updated.db");
+    const std::string rebuilt_file = GetTempFile("rebuilt.db");
+
+    MakeBase(MakeRequestsText(previous, MakeRoutingSettings(), previous_file), std::nullopt);
+    MakeBase(MakeRequestsText(current, MakeRoutingSettings(), updated_file), previous_file);
+    MakeBase(MakeRequestsText(current, MakeRoutingSettings(), rebuilt_file), std::nullopt);
+
+    const std::string expected = ProcessRequests(MakeRequestsText(current, MakeRoutingSettings(), rebuilt_file));
+    assert(ProcessRequests(MakeRequestsText(current, MakeRoutingSettings(), updated_file)) == expected);
+
+    // The previous base may be the file being written
+    MakeBase(MakeRequestsText(current, MakeRoutingSettings(), previous_file), previous_file);
+    assert(ProcessRequests(MakeRequestsText(current, MakeRoutingSettings(), previous_file)) == expected);
+
+    for (const std::string& file : {previous_file, updated_file, rebuilt_file}) {
+        std::filesystem::remove(file);
+    }
+}
+
+std::string ReadFile(const std::string& file) {
+    std::ifstream in(file, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Catalogues of one input sit at different addresses, their bases are the same anyway
+void TestSameInputSameBase() {
+    const std::string first_file = GetTempFile("same_first.db");
+    const std::string second_file = GetTempFile("same_second.db");
+    const TestNetwork network = MakeTestNetwork(3, 40, 14);
+    MakeBase(MakeRequestsText(network, MakeRoutingSettings(), first_file), std::nullopt);
+    MakeBase(MakeRequestsText(network, MakeRoutingSettings(), second_file), std::nullopt);
+
+    const std::string first_base = ReadFile(first_file);
+    assert(!first_base.empty());
+    assert(ReadFile(second_file) == first_base);
+
+    std::filesystem::remove(first_file);
+    std::filesystem::remove(second_file);
+}
+
+// Map data isn't shared between handlers of different catalogues in one process
+void TestMapsOfSeveralBases() {
+    const std::string first_file = GetTempFile("first.db");
+    const std::string second_file = GetTempFile("second.db");
+    const std::string first = MakeRequestsText(MakeTestNetwork(5, 20, 6), MakeRoutingSettings(), first_file);
+    const std::string second = MakeRequestsText(MakeTestNetwork(6, 25, 8), MakeRoutingSettings(), second_file);
+    MakeBase(first, std::nullopt);
+    MakeBase(second, std::nullopt);
+
+    const std::string first_answers = ProcessRequests(first);
+    const std::string second_answers = ProcessRequests(second);
+    assert(first_answers != second_answers);
+    assert(ProcessRequests(first) == first_answers);
+    assert(ProcessRequests(second) == second_answers);
+
+    std::filesystem::remove(first_file);
+    std::filesystem::remove(second_file);
+}
+
+} //namespace
+
+void TestBases() {
+    TestMissingPreviousBase();
+    TestBrokenPreviousBase();
+    TestUpdateMatchesRebuild();
+    TestMapsOfSeveralBases();
+    TestSameInputSameBase();
+}
+
+} //namespace tests
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "graph.h"
+#include "radix_heap.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Shortest paths from one source vertex to all others (Dijkstra's algorithm).
+// Unlike Router it needs O(V) memory, so it suits graphs where only some sources are asked.
+// Unsigned integer weights are searched with RadixHeap instead of a binary heap.
+template <typename Weight>
+class ShortestPathsTree {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    ShortestPathsTree(const Graph& graph, VertexId from);
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    VertexId GetSource() const {
+        return from_;
+    }
+
+    std::optional<Weight> GetWeight(VertexId to) const;
+
+    // Last edge of the route to the vertex, std::nullopt for the source and unreachable vertexes
+    std::optional<EdgeId> GetLastEdge(VertexId to) const;
+
+    std::optional<RouteInfo> BuildRoute(VertexId to) const;
+
+private:
+    struct VertexData {
+        Weight weight;
+        std::optional<EdgeId> prev_edge;
+    };
+
+    template <typename Queue>
+    void Search(Queue& queue);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    VertexId from_;
+    std::vector<std::optional<VertexData>> vertexes_data_;
+};
+
+template <typename Weight>
+ShortestPathsTree<Weight>::ShortestPathsTree(const Graph& graph, VertexId from)
+    : graph_(graph)
+    , from_(from)
+    , vertexes_data_(graph.GetVertexCount())
+{
+    if constexpr (std::is_integral_v<Weight> && std::is_unsigned_v<Weight>) {
+        RadixHeap<Weight, VertexId> queue;
+        Search(queue);
+    } else {
+        struct BinaryHeap {
+            using Item = std::pair<Weight, VertexId>;
+
+            bool Empty() const {
+                return queue.empty();
+            }
+            void Push(Weight weight, VertexId vertex) {
+                queue.push({weight, vertex});
+            }
+            Item Pop() {
+                Item result = queue.top();
+                queue.pop();
+                return result;
+            }
+
+            std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        } queue;
+        Search(queue);
+    }
+}
+
+template <typename Weight>
+template <typename Queue>
+void ShortestPathsTree<Weight>::Search(Queue& queue) {
+    vertexes_data_.at(from_) = VertexData{ZERO_WEIGHT, std::nullopt};
+    queue.Push(ZERO_WEIGHT, from_);
+
+    while (!queue.Empty()) {
+        const auto [weight, vertex] = queue.Pop();
+        if (vertexes_data_[vertex]->weight < weight) {
+            continue;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            auto& vertex_data = vertexes_data_[edge.to];
+            if (!vertex_data || candidate_weight < vertex_data->weight) {
+                vertex_data = VertexData{candidate_weight, edge_id};
+                queue.Push(candidate_weight, edge.to);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<Weight> ShortestPathsTree<Weight>::GetWeight(VertexId to) const {
+    const auto& vertex_data = vertexes_data_.at(to);
+    if (!vertex_data) {
+        return std::nullopt;
+    }
+    return vertex_data->weight;
+}
+
+template <typename Weight>
+std::optional<EdgeId> ShortestPathsTree<Weight>::GetLastEdge(VertexId to) const {
+    const auto& vertex_data = vertexes_data_.at(to);
+    if (!vertex_data) {
+        return std::nullopt;
+    }
+    return vertex_data->prev_edge;
+}
+
+template <typename Weight>
+std::optional<typename ShortestPathsTree<Weight>::RouteInfo>
+ShortestPathsTree<Weight>::BuildRoute(VertexId to) const {
+    const auto& vertex_data = vertexes_data_.at(to);
+    if (!vertex_data) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = vertex_data->prev_edge;
+         edge_id;
+         edge_id = vertexes_data_[graph_.GetEdge(*edge_id).from]->prev_edge)
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{vertex_data->weight, std::move(edges)};
+}
+
+}  // namespace graph
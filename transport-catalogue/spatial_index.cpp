@@ -0,0 +1,192 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace geo {
+
+namespace {
+
+// Computed distances lose precision at short ones, as acos of about 1 does
+const double BOUND_TOLERANCE = 1.0;
+
+bool IsCloser(const GridIndex::Neighbour& lhs, const GridIndex::Neighbour& rhs) {
+    return std::tie(lhs.distance, lhs.index) < std::tie(rhs.distance, rhs.index);
+}
+
+} // namespace
+
+GridIndex::GridIndex(const std::vector<Coordinates>& points) {
+    if (points.empty()) {
+        return;
+    }
+
+    min_lat_ = max_lat_ = points.front().lat;
+    min_lng_ = max_lng_ = points.front().lng;
+    for (const Coordinates& point : points) {
+        min_lat_ = std::min(min_lat_, point.lat);
+        max_lat_ = std::max(max_lat_, point.lat);
+        min_lng_ = std::min(min_lng_, point.lng);
+        max_lng_ = std::max(max_lng_, point.lng);
+    }
+
+    // Sizes are in degrees of latitude, a degree of longitude is shorter by the cosine
+    const double lng_scale = std::max(std::cos((min_lat_ + max_lat_) / 2 * DEG_TO_RAD), 1e-6);
+    const double height = max_lat_ - min_lat_;
+    const double width = (max_lng_ - min_lng_) * lng_scale;
+    const double cells = static_cast<double>(std::max<size_t>(1, points.size() / POINTS_PER_CELL));
+
+    // A flat box gets a row or a column of cells
+    double side = std::max(std::sqrt(height * width / cells), std::max(height, width) / cells);
+    if (!(side > 0)) {
+        side = 1;
+    }
+    cell_height_ = side;
+    cell_width_ = side / lng_scale;
+    rows_ = static_cast<size_t>(height / cell_height_) + 1;
+    columns_ = static_cast<size_t>((max_lng_ - min_lng_) / cell_width_) + 1;
+
+    // Points are sorted by cells with a counting sort
+    std::vector<size_t> cells_of_points(points.size());
+    cell_begins_.assign(rows_ * columns_ + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        cells_of_points[i] = GetRow(points[i].lat) * columns_ + GetColumn(points[i].lng);
+        ++cell_begins_[cells_of_points[i] + 1];
+    }
+    for (size_t i = 1; i < cell_begins_.size(); ++i) {
+        cell_begins_[i] += cell_begins_[i - 1];
+    }
+
+    points_.resize(points.size());
+    indexes_.resize(points.size());
+    std::vector<uint32_t> positions(cell_begins_.begin(), cell_begins_.end() - 1);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const uint32_t position = positions[cells_of_points[i]]++;
+        points_[position] = points[i];
+        indexes_[position] = static_cast<uint32_t>(i);
+    }
+}
+
+std::vector<GridIndex::Neighbour> GridIndex::FindNearest(Coordinates center, size_t count,
+                                                         double max_distance) const {
+    // Max-heap by IsCloser of the nearest points found so far
+    std::vector<Neighbour> result;
+    if (points_.empty() || count == 0) {
+        return result;
+    }
+
+    auto visit_cell = [&](size_t row, size_t column) {
+        const size_t cell = row * columns_ + column;
+        for (uint32_t i = cell_begins_[cell]; i < cell_begins_[cell + 1]; ++i) {
+            const Neighbour neighbour{indexes_[i], ComputeDistance(center, points_[i])};
+            if (neighbour.distance > max_distance) {
+                continue;
+            }
+            if (result.size() < count) {
+                result.push_back(neighbour);
+                std::push_heap(result.begin(), result.end(), IsCloser);
+            } else if (IsCloser(neighbour, result.front())) {
+                std::pop_heap(result.begin(), result.end(), IsCloser);
+                result.back() = neighbour;
+                std::push_heap(result.begin(), result.end(), IsCloser);
+            }
+        }
+    };
+
+    const int64_t center_row = static_cast<int64_t>(GetRow(center.lat));
+    const int64_t center_column = static_cast<int64_t>(GetColumn(center.lng));
+    const int64_t rows = static_cast<int64_t>(rows_);
+    const int64_t columns = static_cast<int64_t>(columns_);
+
+    for (int64_t ring = 0; ; ++ring) {
+        const int64_t first_row = std::max<int64_t>(center_row - ring, 0);
+        const int64_t last_row = std::min(center_row + ring, rows - 1);
+        const int64_t first_column = std::max<int64_t>(center_column - ring, 0);
+        const int64_t last_column = std::min(center_column + ring, columns - 1);
+        for (int64_t row = first_row; row <= last_row; ++row) {
+            if (row == center_row - ring || row == center_row + ring) {
+                for (int64_t column = first_column; column <= last_column; ++column) {
+                    visit_cell(row, column);
+                }
+            } else {
+                if (center_column - ring >= 0) {
+                    visit_cell(row, center_column - ring);
+                }
+                if (ring > 0 && center_column + ring < columns) {
+                    visit_cell(row, center_column + ring);
+                }
+            }
+        }
+
+        // Infinite once all cells are visited
+        const double bound = GetLowerBound(center, ring) - BOUND_TOLERANCE;
+        if (std::isinf(bound) || bound > max_distance || (result.size() == count && bound > result.front().distance)) {
+            break;
+        }
+    }
+
+    std::sort_heap(result.begin(), result.end(), IsCloser);
+    return result;
+}
+
+size_t GridIndex::GetRow(double lat) const {
+    const double row = std::floor((lat - min_lat_) / cell_height_);
+    return row <= 0 ? 0 : std::min(static_cast<size_t>(row), rows_ - 1);
+}
+
+size_t GridIndex::GetColumn(double lng) const {
+    const double column = std::floor((lng - min_lng_) / cell_width_);
+    return column <= 0 ? 0 : std::min(static_cast<size_t>(column), columns_ - 1);
+}
+
+double GridIndex::GetLowerBound(Coordinates center, size_t ring) const {
+    const double infinity = std::numeric_limits<double>::infinity();
+    const size_t center_row = GetRow(center.lat);
+    const size_t center_column = GetColumn(center.lng);
+
+    // Degrees from the center to the nearest unvisited row and column, infinite if there are none
+    double row_gap = infinity;
+    if (center_row + ring + 1 < rows_) {
+        row_gap = std::min(row_gap, min_lat_ + (center_row + ring + 1) * cell_height_ - center.lat);
+    }
+    if (center_row > ring) {
+        row_gap = std::min(row_gap, center.lat - (min_lat_ + (center_row - ring) * cell_height_));
+    }
+    double column_gap = infinity;
+    if (center_column + ring + 1 < columns_) {
+        column_gap = std::min(column_gap, min_lng_ + (center_column + ring + 1) * cell_width_ - center.lng);
+    }
+    if (center_column > ring) {
+        column_gap = std::min(column_gap, center.lng - (min_lng_ + (center_column - ring) * cell_width_));
+    }
+    if (std::isinf(row_gap) && std::isinf(column_gap)) {
+        return infinity;
+    }
+
+    // Longitudes are compared without wrapping, which holds while they span a half circle
+    const bool use_lng = std::max(max_lng_, center.lng) - std::min(min_lng_, center.lng) <= 180;
+    const double box_lat_gap = std::max({0., min_lat_ - center.lat, center.lat - max_lat_});
+    const double box_lng_gap = use_lng ? std::max({0., min_lng_ - center.lng, center.lng - max_lng_}) : 0;
+    const double max_abs_lat = std::max({std::abs(min_lat_), std::abs(max_lat_), std::abs(center.lat)});
+    const double lng_scale = std::cos(max_abs_lat * DEG_TO_RAD);
+
+    // By haversine sin^2(d / 2) = sin^2(dlat / 2) + cos(lat1) * cos(lat2) * sin^2(dlng / 2),
+    // and the cosines are not less than the one of the latitude farthest from the equator
+    auto bound = [lng_scale](double lat_gap, double lng_gap) {
+        const double lat_sin = std::sin(std::max(lat_gap, 0.) * DEG_TO_RAD / 2);
+        const double lng_sin = lng_scale * std::sin(std::min(std::max(lng_gap, 0.), 180.) * DEG_TO_RAD / 2);
+        return 2 * EARTH_RADIUS * std::asin(std::min(1., std::sqrt(lat_sin * lat_sin + lng_sin * lng_sin)));
+    };
+
+    double result = infinity;
+    if (!std::isinf(row_gap)) {
+        result = std::min(result, bound(row_gap, box_lng_gap));
+    }
+    if (!std::isinf(column_gap)) {
+        result = std::min(result, bound(box_lat_gap, use_lng ? column_gap : 0));
+    }
+    return result;
+}
+
+} // namespace geo
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace geo {
+
+// Uniform grid over the bounding box of points, cells are about square in meters and hold
+// a couple of points on average. Nearest points are searched ring by ring of cells around
+// the center, until a lower bound of the distance to unvisited cells exceeds the farthest
+// point found.
+class GridIndex {
+public:
+    struct Neighbour {
+        size_t index;
+        double distance;
+    };
+
+    // Average number of points per cell
+    static const size_t POINTS_PER_CELL = 2;
+
+    GridIndex() = default;
+
+    // Points are addressed by their indexes in the vector
+    explicit GridIndex(const std::vector<Coordinates>& points);
+
+    // At most count points not farther than max_distance meters, nearest first.
+    // Points at equal distance go by index.
+    std::vector<Neighbour> FindNearest(Coordinates center, size_t count,
+                                       double max_distance = std::numeric_limits<double>::infinity()) const;
+
+    size_t GetSize() const {
+        return points_.size();
+    }
+
+private:
+    size_t GetRow(double lat) const;
+    size_t GetColumn(double lng) const;
+
+    // No point in cells farther than ring cells from the center one is closer than this
+    double GetLowerBound(Coordinates center, size_t ring) const;
+
+    double min_lat_ = 0;
+    double min_lng_ = 0;
+    double max_lat_ = 0;
+    double max_lng_ = 0;
+    double cell_height_ = 1;  // degrees
+    double cell_width_ = 1;   // degrees
+    size_t rows_ = 0;
+    size_t columns_ = 0;
+
+    // Points of cell i are [cell_begins_[i], cell_begins_[i + 1]) of points_ and indexes_
+    std::vector<uint32_t> cell_begins_;
+    std::vector<Coordinates> points_;
+    std::vector<uint32_t> indexes_;
+};
+
+} // namespace geo
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include "flat_hash_map.h"
+#include <vector>
+
+namespace domain {
+
+// Interns every name once into large blocks of chars. Views of stored names stay valid while
+// the pool lives, moves included, so they serve as hash table keys elsewhere. Names also get
+// dense ids in the order they were added.
+class StringPool {
+public:
+    using Id = uint32_t;
+
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    StringPool() = default;
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&&) = default;
+
+    // Id of the stored copy, the name is copied only the first time
+    Id Intern(std::string_view name) {
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        const std::string_view stored = Copy(name);
+        const Id id = static_cast<Id>(names_.size());
+        names_.push_back(stored);
+        ids_.emplace(stored, id);
+        return id;
+    }
+
+    // Stored copy of the name
+    std::string_view Store(std::string_view name) {
+        return names_[Intern(name)];
+    }
+
+    std::string_view GetName(Id id) const {
+        return names_.at(id);
+    }
+
+    std::optional<Id> FindId(std::string_view name) const {
+        auto it = ids_.find(name);
+        if (it == ids_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    size_t GetSize() const {
+        return names_.size();
+    }
+
+    // Chars taken by blocks, used or not
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+
+private:
+    std::string_view Copy(std::string_view name) {
+        if (name.empty()) {
+            return {};
+        }
+        char* data = nullptr;
+        if (name.size() > BLOCK_SIZE / 4) {
+            // Long names get blocks of their own, so the current one isn't left half empty
+            data = large_blocks_.emplace_back(std::make_unique<char[]>(name.size())).get();
+            capacity_ += name.size();
+        } else {
+            if (blocks_.empty() || block_used_ + name.size() > BLOCK_SIZE) {
+                blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+                capacity_ += BLOCK_SIZE;
+                block_used_ = 0;
+            }
+            data = blocks_.back().get() + block_used_;
+            block_used_ += name.size();
+        }
+        std::memcpy(data, name.data(), name.size());
+        return {data, name.size()};
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::vector<std::unique_ptr<char[]>> large_blocks_;
+    size_t block_used_ = 0;
+    size_t capacity_ = 0;
+
+    std::vector<std::string_view> names_;
+    container::FlatHashMap<std::string_view, Id> ids_;
+};
+
+} // namespace domain
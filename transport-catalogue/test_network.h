@@ -0,0 +1,143 @@
+#pragma once
+
+#include "json.h"
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tests {
+
+struct TestStop {
+    std::string name;
+    geo::Coordinates coordinates;
+    std::map<std::string, int> road_distances;
+};
+
+struct TestBus {
+    std::string name;
+    std::vector<std::string> stops;
+    bool is_roundtrip;
+};
+
+// Random stops and buses between them, every road driven by a bus has its distance
+struct TestNetwork {
+    std::vector<TestStop> stops;
+    std::vector<TestBus> buses;
+};
+
+inline TestNetwork MakeTestNetwork(uint32_t seed, size_t stops_count, size_t buses_count) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> offsets(0, 0.05);
+    std::uniform_int_distribution<size_t> stop_indexes(0, stops_count - 1);
+    std::uniform_int_distribution<size_t> route_sizes(2, 7);
+    std::uniform_int_distribution<int> distances(300, 3000);
+
+    TestNetwork result;
+    for (size_t i = 0; i < stops_count; ++i) {
+        result.stops.push_back({"Stop " + std::to_string(i), {55.6 + offsets(generator), 37.5 + offsets(generator)}, {}});
+    }
+    for (size_t i = 0; i < buses_count; ++i) {
+        TestBus bus{std::to_string(i), {}, i % 3 == 0};
+        const size_t route_size = route_sizes(generator);
+        while (bus.stops.size() < route_size) {
+            const std::string& stop = result.stops[stop_indexes(generator)].name;
+            if (bus.stops.empty() || bus.stops.back() != stop) {
+                bus.stops.push_back(stop);
+            }
+        }
+        if (bus.is_roundtrip) {
+            bus.stops.push_back(bus.stops.front());
+        }
+        for (size_t j = 1; j < bus.stops.size(); ++j) {
+            const size_t from = std::stoul(bus.stops[j - 1].substr(5));
+            result.stops[from].road_distances.emplace(bus.stops[j], distances(generator));
+        }
+        result.buses.push_back(std::move(bus));
+    }
+    return result;
+}
+
+// Adds stops and buses of the network, which should outlive the catalogue
+inline void FillCatalogue(TransportCatalogue& catalogue, const TestNetwork& network) {
+    for (const TestStop& stop : network.stops) {
+        std::unordered_map<std::string_view, int> neighbours(stop.road_distances.begin(), stop.road_distances.end());
+        catalogue.AddStop({stop.name, stop.coordinates, std::move(neighbours)});
+    }
+    for (const TestBus& bus : network.buses) {
+        catalogue.AddBus({bus.name, std::vector<std::string_view>(bus.stops.begin(), bus.stops.end()), bus.is_roundtrip});
+    }
+}
+
+inline json::Array MakeBaseRequests(const TestNetwork& network) {
+    json::Array result;
+    for (const TestStop& stop : network.stops) {
+        json::Dict distances;
+        for (const auto& [name, distance] : stop.road_distances) {
+            distances[name] = distance;
+        }
+        result.push_back(json::Dict{{"type", std::string("Stop")},
+                                    {"name", stop.name},
+                                    {"latitude", stop.coordinates.lat},
+                                    {"longitude", stop.coordinates.lng},
+                                    {"road_distances", distances}});
+    }
+    for (const TestBus& bus : network.buses) {
+        json::Array stops(bus.stops.begin(), bus.stops.end());
+        result.push_back(json::Dict{{"type", std::string("Bus")},
+                                    {"name", bus.name},
+                                    {"stops", stops},
+                                    {"is_roundtrip", bus.is_roundtrip}});
+    }
+    return result;
+}
+
+inline json::Dict MakeRenderSettings() {
+    return json::Dict{{"width", 600.0}, {"height", 400.0}, {"padding", 50.0},
+                      {"line_width", 14.0}, {"stop_radius", 5.0},
+                      {"bus_label_font_size", 20}, {"bus_label_offset", json::Array{7.0, 15.0}},
+                      {"stop_label_font_size", 18}, {"stop_label_offset", json::Array{7.0, -3.0}},
+                      {"underlayer_color", std::string("white")}, {"underlayer_width", 3.0},
+                      {"color_palette", json::Array{std::string("green"), std::string("red")}}};
+}
+
+// Route requests between every pair of the first stops, Bus requests of all buses and a Map one
+inline json::Array MakeStatRequests(const TestNetwork& network, size_t route_stops_count) {
+    json::Array result;
+    int id = 1;
+    const size_t count = std::min(route_stops_count, network.stops.size());
+    for (size_t from = 0; from < count; ++from) {
+        for (size_t to = 0; to < count; ++to) {
+            result.push_back(json::Dict{{"id", id++}, {"type", std::string("Route")},
+                                        {"from", network.stops[from].name},
+                                        {"to", network.stops[to].name}});
+        }
+    }
+    for (const TestBus& bus : network.buses) {
+        result.push_back(json::Dict{{"id", id++}, {"type", std::string("Bus")}, {"name", bus.name}});
+    }
+    result.push_back(json::Dict{{"id", id++}, {"type", std::string("Map")}});
+    return result;
+}
+
+inline std::string MakeRequestsText(const TestNetwork& network, const json::Dict& routing_settings,
+                                    const std::string& base_file) {
+    json::Dict requests{{"base_requests", MakeBaseRequests(network)},
+                        {"render_settings", MakeRenderSettings()},
+                        {"routing_settings", routing_settings},
+                        {"serialization_settings", json::Dict{{"file", base_file}}},
+                        {"stat_requests", MakeStatRequests(network, 12)}};
+    std::ostringstream out;
+    json::Print(json::Document{requests}, out);
+    return out.str();
+}
+
+} //namespace tests
@@ -12,18 +12,32 @@
 #include <set>
 
 TransportCatalogue::TransportCatalogue(TransportCatalogue&& other) {
+    std::swap(names_, other.names_);
     std::swap(stops_, other.stops_);
     std::swap(buses_, other.buses_);
     std::swap(stops_refs_, other.stops_refs_);
     std::swap(buses_refs_, other.buses_refs_);
     std::swap(stops_to_buses_, other.stops_to_buses_);
     std::swap(lengths_data_, other.lengths_data_);
+    std::swap(stops_trig_, other.stops_trig_);
+    std::swap(geo_lengths_, other.geo_lengths_);
     std::swap(neighbours_distance_, other.neighbours_distance_);
+    std::swap(stops_index_, other.stops_index_);
+    std::swap(stops_names_, other.stops_names_);
+    std::swap(buses_names_, other.buses_names_);
+    std::swap(stops_used_, other.stops_used_);
+    std::swap(buses_for_render_, other.buses_for_render_);
 }
 
 void TransportCatalogue::AddStop(const domain::StopRequest& request) {
     domain::Stop& stop = GetStopRef(request.name);
     stop.coordinates = request.coordinates;
+    stops_trig_.SetPoint(stop.index, stop.coordinates);
+    stops_index_.reset();
+    stops_used_.reset();
+    geo_lengths_.clear();
+    // Curvature of every bus of the stop depends on its coordinates
+    lengths_data_.clear();
     for (const auto& [name, distance] : request.neighbours) {
         domain::Stop& other_stop = GetStopRef(name);
         neighbours_distance_[{&stop, &other_stop}] = distance;
@@ -31,8 +45,15 @@ void TransportCatalogue::AddStop(const domain::StopRequest& request) {
 }
 
 void TransportCatalogue::AddBus(const domain::BusRequest& request) {
+    const size_t bus_index = buses_.size();
     domain::Bus& bus = buses_.emplace_back();
-    bus.name = std::string(request.name);
+    bus.name = names_.Store(request.name);
+    bus.index = bus_index;
+    // A bus added again under its name replaces the old one
+    lengths_data_.erase(bus.name);
+    buses_names_.reset();
+    stops_used_.reset();
+    buses_for_render_.reset();
     buses_refs_[bus.name] = &bus;
     bus.is_roundtrip = request.is_roundtrip;
 
@@ -44,32 +65,47 @@ void TransportCatalogue::AddBus(const domain::BusRequest& request) {
         domain::Stop& stop_in_catalogue = GetStopRef(stop);
         unique_stops.insert(stop_in_catalogue.name);
         bus.stops.push_back(&stop_in_catalogue);
-        stops_to_buses_[stop_in_catalogue.name].insert(bus.name);
-    }
-
-    if (!bus.is_roundtrip) {
-        for (int i = bus.stops.size() - 2; i >= 0; --i) {
-            bus.stops.push_back(bus.stops[i]);
-        }
+        stops_to_buses_[stop_in_catalogue.name].Set(bus_index);
     }
 
     bus.unique_stops = unique_stops.size();
 }
 
 domain::StopInfo TransportCatalogue::GetStopInfo(const std::string_view name) const {
-    static const std::set<std::string_view> empty_;
-    bool was_found = stops_refs_.count(name) != 0;
+    if (stops_refs_.count(name) == 0) {
+        return {name, {}, false};
+    }
 
-    bool have_buses = stops_to_buses_.count(name) != 0;
-    if (was_found) {
-        if (have_buses) {
-            return {name, stops_to_buses_.at(name), true};
-        } else {
-            return {name, empty_, true};
-        }
-    } else {
-        return {name, empty_, false};
+    auto it = stops_to_buses_.find(name);
+    if (it == stops_to_buses_.end()) {
+        return {name, {}, true};
     }
+    return {name, GetBusNames(it->second), true};
+}
+
+domain::DirectBusesInfo TransportCatalogue::GetDirectBuses(std::string_view from, std::string_view to) const {
+    if (stops_refs_.count(from) == 0 || stops_refs_.count(to) == 0) {
+        return {from, to, {}, false};
+    }
+
+    auto from_it = stops_to_buses_.find(from);
+    auto to_it = stops_to_buses_.find(to);
+    if (from_it == stops_to_buses_.end() || to_it == stops_to_buses_.end()) {
+        return {from, to, {}, true};
+    }
+    return {from, to, GetBusNames(container::DynamicBitset::Intersect(from_it->second, to_it->second)), true};
+}
+
+std::vector<std::string_view> TransportCatalogue::GetBusNames(const container::DynamicBitset& buses) const {
+    std::vector<std::string_view> result;
+    result.reserve(buses.Count());
+    buses.ForEachSet([this, &result](size_t index) {
+        result.push_back(buses_[index].name);
+    });
+    std::sort(result.begin(), result.end());
+    // A bus added again under its name keeps the bits of the replaced one
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
 }
 
 domain::BusInfo TransportCatalogue::GetBusInfo(const std::string_view name) const {
@@ -84,9 +120,7 @@ domain::BusInfo TransportCatalogue::GetBusInfo(const std::string_view name) cons
 
     domain::Bus& bus = *(*it).second;
 
-    for (const domain::Stop* stop : bus.stops) {
-        result.stops.push_back((*stop).name);
-    }
+    result.stops = bus.GetRoute();
 
     result.length = ComputeRouteLength(name);
 
@@ -95,6 +129,24 @@ domain::BusInfo TransportCatalogue::GetBusInfo(const std::string_view name) cons
     return result;
 }
 
+std::vector<domain::NearbyStop> TransportCatalogue::GetNearbyStops(geo::Coordinates center, size_t count,
+                                                                    double max_distance) const {
+    if (!stops_index_) {
+        std::vector<geo::Coordinates> points;
+        points.reserve(stops_.size());
+        for (const domain::Stop& stop : stops_) {
+            points.push_back(stop.coordinates);
+        }
+        stops_index_ = std::make_unique<geo::GridIndex>(points);
+    }
+
+    std::vector<domain::NearbyStop> result;
+    for (const geo::GridIndex::Neighbour& neighbour : stops_index_->FindNearest(center, count, max_distance)) {
+        result.push_back({stops_[neighbour.index].name, neighbour.distance});
+    }
+    return result;
+}
+
 using StopPtrPair = std::pair<const domain::Stop*,const domain::Stop*>;
 
 domain::Stop& TransportCatalogue::GetStopRef(std::string_view name) {
@@ -102,8 +154,11 @@ domain::Stop& TransportCatalogue::GetStopRef(std::string_view name) {
     if (it != stops_refs_.end()) {
         return *(*it).second;
     }
-    domain::Stop& stop = stops_.emplace_back(domain::Stop{std::string(name), {}});
+    domain::Stop& stop = stops_.emplace_back(domain::Stop{names_.Store(name), {}, stops_.size()});
     stops_refs_[stop.name] = &stop;
+    stops_trig_.AddPoint(stop.coordinates);
+    stops_names_.reset();
+    stops_index_.reset();
     return stop;
 }
 
@@ -117,7 +172,7 @@ int TransportCatalogue::GetRealDistance(const domain::Stop& a, const domain::Sto
     if (it != end) {
         return (*it).second;
     }
-    throw std::logic_error("GetRealDistance: NO DATA! (" + a.name + " -> " + b.name + ")\n");
+    throw std::logic_error("GetRealDistance: NO DATA! (" + std::string(a.name) + " -> " + std::string(b.name) + ")\n");
     return -1;
 }
 
@@ -141,14 +196,13 @@ domain::DistanceInfo TransportCatalogue::ComputeRouteLength(std::string_view nam
     }
 
     domain::Bus& bus = *buses_refs_.at(name);
-    std::vector<domain::Stop*>& stops = bus.stops;
+    const domain::RouteView<domain::Stop*> stops = bus.GetRoute();
     domain::DistanceInfo result;
 
+    ComputeGeoLengths();
+    result.geo_length = geo_lengths_[bus.index];
     for (size_t i = 1; i < stops.size(); ++i) {
-        domain::Stop& cur_stop = *stops[i];
-        domain::Stop& pre_stop = *stops[i - 1];
-        result.geo_length  += ComputeDistance(pre_stop.coordinates, cur_stop.coordinates);
-        result.real_length += GetRealDistance(pre_stop, cur_stop);
+        result.real_length += GetRealDistance(*stops[i - 1], *stops[i]);
     }
 
     result.curvature = result.real_length / result.geo_length;
@@ -158,34 +212,102 @@ domain::DistanceInfo TransportCatalogue::ComputeRouteLength(std::string_view nam
     return lengths_data_.at(bus.name);
 }
 
-std::set<domain::BusForRender> TransportCatalogue::GetBusesForRender() const {
-    std::set<domain::BusForRender> result;
+void TransportCatalogue::ComputeGeoLengths() const {
+    if (geo_lengths_.size() == buses_.size()) {
+        return;
+    }
 
-    for (const domain::Bus& bus : buses_) {
-        if (!bus.stops.empty()) {
-            domain::BusForRender bus_for_render;
-            bus_for_render.name = bus.name;
-            bus_for_render.is_roundtrip = bus.is_roundtrip;
+    std::vector<uint32_t> from;
+    std::vector<uint32_t> to;
+    for (size_t i = geo_lengths_.size(); i < buses_.size(); ++i) {
+        const domain::RouteView<domain::Stop*> stops = buses_[i].GetRoute();
+        for (size_t j = 1; j < stops.size(); ++j) {
+            from.push_back(static_cast<uint32_t>(stops[j - 1]->index));
+            to.push_back(static_cast<uint32_t>(stops[j]->index));
+        }
+    }
+    std::vector<double> distances(from.size());
+    stops_trig_.ComputeDistances(from.data(), to.data(), from.size(), distances.data());
+
+    // Summed segment by segment, in the order of stops
+    size_t segment = 0;
+    for (size_t i = geo_lengths_.size(); i < buses_.size(); ++i) {
+        double length = 0;
+        for (size_t j = 1; j < buses_[i].GetRoute().size(); ++j) {
+            length += distances[segment++];
+        }
+        geo_lengths_.push_back(length);
+    }
+}
 
-            for (const domain::Stop* stop : bus.stops) {
-                bus_for_render.stops.push_back(stop->name);
-            }
+std::vector<domain::NameSuggestion> TransportCatalogue::Suggest(std::string_view prefix, size_t count) const {
+    const std::vector<std::string_view> stops = GetStopsNames().FindByPrefix(prefix, count);
+    const std::vector<std::string_view> buses = GetBusesNames().FindByPrefix(prefix, count);
 
-            result.insert(bus_for_render);
+    std::vector<domain::NameSuggestion> result;
+    size_t stop_i = 0;
+    size_t bus_i = 0;
+    while (result.size() < count && (stop_i < stops.size() || bus_i < buses.size())) {
+        if (bus_i == buses.size() || (stop_i < stops.size() && stops[stop_i] <= buses[bus_i])) {
+            result.push_back({stops[stop_i++], false});
+        } else {
+            result.push_back({buses[bus_i++], true});
         }
     }
     return result;
 }
 
-std::vector<std::pair<std::string_view, geo::Coordinates>> TransportCatalogue::GetStopsUsed() const {
-    std::vector<std::pair<std::string_view, geo::Coordinates>> result;
-    using elem_type = std::pair<const std::string_view, std::set<std::string_view>>;
+std::vector<uint32_t> TransportCatalogue::GetStopsOrder() const {
+    return GetStopsNames().GetOrder();
+}
+
+std::vector<uint32_t> TransportCatalogue::GetBusesOrder() const {
+    return GetBusesNames().GetOrder();
+}
 
-    for (const elem_type& stop : stops_to_buses_) {
-        result.push_back({stop.first, stops_refs_.at(stop.first)->coordinates});
+void TransportCatalogue::SetNamesOrder(const std::vector<uint32_t>& stops_order,
+                                       const std::vector<uint32_t>& buses_order) {
+    stops_names_ = std::make_unique<domain::NameIndex>(GetNames(stops_), stops_order);
+    buses_names_ = std::make_unique<domain::NameIndex>(GetNames(buses_), buses_order);
+}
+
+const domain::NameIndex& TransportCatalogue::GetStopsNames() const {
+    if (!stops_names_) {
+        stops_names_ = std::make_unique<domain::NameIndex>(GetNames(stops_));
     }
+    return *stops_names_;
+}
 
-    return result;
+const domain::NameIndex& TransportCatalogue::GetBusesNames() const {
+    if (!buses_names_) {
+        buses_names_ = std::make_unique<domain::NameIndex>(GetNames(buses_));
+    }
+    return *buses_names_;
+}
+
+domain::BusesForRender TransportCatalogue::GetBusesForRender() const {
+    if (!buses_for_render_) {
+        buses_for_render_.emplace();
+        for (uint32_t position : GetBusesNames().GetOrder()) {
+            const domain::Bus& bus = buses_[position];
+            // A name given to several buses is rendered once
+            if (!bus.stops.empty() && (buses_for_render_->empty() || buses_for_render_->back()->name != bus.name)) {
+                buses_for_render_->push_back(&bus);
+            }
+        }
+    }
+    return ranges::AsRange(*buses_for_render_);
+}
+
+domain::StopsUsed TransportCatalogue::GetStopsUsed() const {
+    if (!stops_used_) {
+        stops_used_.emplace();
+        stops_used_->reserve(stops_to_buses_.size());
+        for (const auto& stop : stops_to_buses_) {
+            stops_used_->push_back({stop.first, stops_refs_.at(stop.first)->coordinates});
+        }
+    }
+    return ranges::AsRange(*stops_used_);
 }
 
 std::vector<const domain::Stop*> TransportCatalogue::GetAllStops() const {
@@ -208,8 +330,15 @@ std::vector<const domain::Bus*> TransportCatalogue::GetAllBuses() const {
 
 std::vector<std::pair<std::pair<std::string_view, std::string_view>, int>>
 TransportCatalogue::GetDistances() const {
-    std::vector<std::pair<std::pair<std::string_view, std::string_view>, int>> result(neighbours_distance_.size());
-        std::transform(neighbours_distance_.begin(), neighbours_distance_.end(), result.begin(),
+    // Slots of the map depend on addresses of stops, so pairs are ordered by stop indexes
+    std::vector<std::pair<StopPtrPair, int>> distances(neighbours_distance_.begin(), neighbours_distance_.end());
+    std::sort(distances.begin(), distances.end(), [](const auto& lhs, const auto& rhs) {
+        return std::make_pair(lhs.first.first->index, lhs.first.second->index)
+             < std::make_pair(rhs.first.first->index, rhs.first.second->index);
+    });
+
+    std::vector<std::pair<std::pair<std::string_view, std::string_view>, int>> result(distances.size());
+        std::transform(distances.begin(), distances.end(), result.begin(),
                        [](auto& stops){
                             const domain::Stop* from = stops.first.first;
                             const domain::Stop* to = stops.first.second;
@@ -225,4 +354,19 @@ void TransportCatalogue::AddDistance(std::string_view from, std::string_view to,
     domain::Stop* from_ptr = &GetStopRef(from);
     domain::Stop* to_ptr = &GetStopRef(to);
     neighbours_distance_[{from_ptr, to_ptr}] = distance;
+    ForgetRouteLengths(*from_ptr, *to_ptr);
+}
+
+void TransportCatalogue::ForgetRouteLengths(const domain::Stop& a, const domain::Stop& b) {
+    if (lengths_data_.empty()) {
+        return;
+    }
+    auto a_it = stops_to_buses_.find(a.name);
+    auto b_it = stops_to_buses_.find(b.name);
+    if (a_it == stops_to_buses_.end() || b_it == stops_to_buses_.end()) {
+        return;
+    }
+    container::DynamicBitset::Intersect(a_it->second, b_it->second).ForEachSet([this](size_t index) {
+        lengths_data_.erase(buses_[index].name);
+    });
 }
@@ -4,13 +4,20 @@
 #include <string>
 #include <vector>
 #include <deque>
-#include <unordered_map>
 #include <string_view>
 #include <cassert>
 #include <set>
 #include <variant>
 #include <algorithm>
 #include "domain.h"
+#include "string_pool.h"
+#include "flat_hash_map.h"
+#include "dynamic_bitset.h"
+#include "spatial_index.h"
+#include "name_index.h"
+#include <limits>
+#include <memory>
+#include <optional>
 
 class TransportCatalogue {
 public:
@@ -28,11 +35,31 @@ public:
 
     domain::StopInfo GetStopInfo(const std::string_view name) const;
 
+    // Buses serving both stops, was_found is false if one of them is unknown
+    domain::DirectBusesInfo GetDirectBuses(std::string_view from, std::string_view to) const;
+
     domain::BusInfo GetBusInfo(const std::string_view name) const;
 
-    std::set<domain::BusForRender> GetBusesForRender() const;
+    // At most count stops not farther than max_distance meters from center, nearest first
+    std::vector<domain::NearbyStop> GetNearbyStops(geo::Coordinates center, size_t count,
+                                                   double max_distance = std::numeric_limits<double>::infinity()) const;
+
+    // Stops and buses with names starting with prefix, at most count in the order of names.
+    // A stop goes before a bus of the same name.
+    std::vector<domain::NameSuggestion> Suggest(std::string_view prefix, size_t count) const;
+
+    // Positions in GetAllStops() and GetAllBuses() in the order of names
+    std::vector<uint32_t> GetStopsOrder() const;
+    std::vector<uint32_t> GetBusesOrder() const;
 
-    std::vector<std::pair<std::string_view, geo::Coordinates>> GetStopsUsed() const;
+    // Orders read from a base, so names aren't sorted again. Invalid ones are ignored.
+    void SetNamesOrder(const std::vector<uint32_t>& stops_order, const std::vector<uint32_t>& buses_order);
+
+    // Buses with stops in the order of names. The view is invalidated by AddStop() and AddBus().
+    domain::BusesForRender GetBusesForRender() const;
+
+    // Stops with buses and their coordinates. The view is invalidated by AddStop() and AddBus().
+    domain::StopsUsed GetStopsUsed() const;
 
     int GetDistance(std::string_view from, std::string_view to) const;
 
@@ -53,6 +80,28 @@ private:
 
     domain::DistanceInfo ComputeRouteLength(std::string_view name) const;
 
+    // Drops memoized lengths of buses serving both stops, as they may drive the road between them
+    void ForgetRouteLengths(const domain::Stop& a, const domain::Stop& b);
+
+    // Great-circle lengths of buses added since the last call, by one batch of all their segments
+    void ComputeGeoLengths() const;
+
+    template <typename Items>
+    static std::vector<std::string_view> GetNames(const Items& items) {
+        std::vector<std::string_view> result;
+        result.reserve(items.size());
+        for (const auto& item : items) {
+            result.push_back(item.name);
+        }
+        return result;
+    }
+
+    const domain::NameIndex& GetStopsNames() const;
+    const domain::NameIndex& GetBusesNames() const;
+
+    // Names of buses by their bits, sorted and distinct
+    std::vector<std::string_view> GetBusNames(const container::DynamicBitset& buses) const;
+
     class StopsPairHasher {
     public:
         size_t operator()(const StopPtrPair& stop_pair) const {
@@ -62,11 +111,26 @@ private:
         std::hash<const void*> hasher;
     };
 
+    // All stop and bus names, keys of the maps below are views of it
+    domain::StringPool names_;
     std::deque<domain::Stop> stops_;
     std::deque<domain::Bus> buses_;
-    std::unordered_map<std::string_view, domain::Stop*> stops_refs_;
-    std::unordered_map<std::string_view, domain::Bus*> buses_refs_;
-    std::unordered_map<std::string_view, std::set<std::string_view>> stops_to_buses_;
-    mutable std::unordered_map<std::string_view, domain::DistanceInfo> lengths_data_;
-    std::unordered_map<StopPtrPair, int, StopsPairHasher> neighbours_distance_;
+    container::FlatHashMap<std::string_view, domain::Stop*> stops_refs_;
+    container::FlatHashMap<std::string_view, domain::Bus*> buses_refs_;
+    // Bit i of a stop is set if buses_[i] stops there
+    container::FlatHashMap<std::string_view, container::DynamicBitset> stops_to_buses_;
+    mutable container::FlatHashMap<std::string_view, domain::DistanceInfo> lengths_data_;
+    // Coordinates of stops_ with trigonometry of latitudes, by stop index
+    geo::PointsTrig stops_trig_;
+    // Great-circle lengths by bus index, for a prefix of buses_
+    mutable std::vector<double> geo_lengths_;
+    container::FlatHashMap<StopPtrPair, int, StopsPairHasher> neighbours_distance_;
+    // Grid over stops_, built by the first nearby stops query after stops change
+    mutable std::unique_ptr<geo::GridIndex> stops_index_;
+    // Names of stops_ and buses_ in lexicographic order, built on demand after names change
+    mutable std::unique_ptr<domain::NameIndex> stops_names_;
+    mutable std::unique_ptr<domain::NameIndex> buses_names_;
+    // Storage of the map data views, built on demand after stops or buses change
+    mutable std::optional<std::vector<std::pair<std::string_view, geo::Coordinates>>> stops_used_;
+    mutable std::optional<std::vector<const domain::Bus*>> buses_for_render_;
 };
@@ -7,56 +7,317 @@
 #include "domain.h"
 #include <set>
 #include <vector>
-#include <unordered_map>
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <type_traits>
 
 namespace transport_router {
 
-RouterItems TransportRouter::FindRouteById(VertexId from_id, VertexId to_id) {
+RouterItems TransportRouter::MakeRouterItems(const std::vector<EdgeId>& edges, double weight) const {
     RouterItems result;
 
-    auto opt_info = router_.BuildRoute(from_id, to_id);
+    result.items.resize(edges.size());
 
-    if (!opt_info) {
-        return result;
-    }
-    graph::Router<double>::RouteInfo info = opt_info.value();
-
-    result.items.resize(info.edges.size());
-
-    std::transform(info.edges.begin(), info.edges.end(), result.items.begin(),
+    std::transform(edges.begin(), edges.end(), result.items.begin(),
                    [this](size_t edge_id){
                         return edges_[edge_id];
                    });
 
-    result.total_time = info.weight;
+    result.total_time = weight;
 
     return result;
 }
 
+void TransportRouter::BuildGraph(const request_handler::MapData& data) {
+    for (size_t i = 0; i < data.stops_used.size(); ++i) {
+        stop_vertexes_[data.stops_used[i].first] = i;
+    }
+
+    const domain::BusesForRender& buses = data.buses;
+    assert(std::none_of(buses.begin(), buses.end(), [](const domain::Bus* bus) {
+        return bus->stops.empty();
+    }));
+
+    // Buses are expanded independently by several threads, every thread takes a contiguous
+    // range of buses. Buffers are merged in bus order, so edge ids don't depend on threads number.
+    const size_t threads_number = std::max<size_t>(1, std::min<size_t>(buses.size(),
+                                                                       std::thread::hardware_concurrency()));
+    std::vector<EdgesBuffer> buffers(threads_number);
+
+    auto expand_buses = [&](size_t thread_index) {
+        const size_t begin = buses.size() * thread_index / threads_number;
+        const size_t end   = buses.size() * (thread_index + 1) / threads_number;
+        for (size_t i = begin; i < end; ++i) {
+            AddBus(*buses[i], buffers[thread_index]);
+            buffers[thread_index].bus_ends.push_back(buffers[thread_index].edges.size());
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads_number; ++i) {
+        workers.emplace_back(expand_buses, i);
+    }
+    expand_buses(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Only the lightest edge of a (from, to) pair can be a part of a shortest path, the first
+    // one wins among equal edges as in graph::Router. Loops are never a part of one either.
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<graph::Edge<double>> edges;
+
+    container::FlatHashMap<size_t, EdgeId> pair_edges;
+    size_t bus_index = 0;
+    for (EdgesBuffer& buffer : buffers) {
+        size_t i = 0;
+        for (size_t bus_end : buffer.bus_ends) {
+            // Candidates of pairs are kept only for updates
+            BusEdges* bus_edges = enable_updates_ ? &bus_edges_[buses[bus_index]->name] : nullptr;
+            ++bus_index;
+            if (bus_edges) {
+                bus_edges->generated = bus_end - i;
+            }
+            for (; i < bus_end; ++i) {
+                const graph::Edge<double>& edge = buffer.edges[i];
+                ++edges_stats_.generated;
+                if (edge.from == edge.to) {
+                    continue;
+                }
+                const size_t key = GetPairKey(edge.from, edge.to);
+                if (bus_edges) {
+                    pair_candidates_[key].push_back(buffer.items[i]);
+                    bus_edges->pairs.push_back(key);
+                }
+
+                auto [it, inserted] = pair_edges.emplace(key, edges.size());
+                if (inserted) {
+                    edges.push_back(edge);
+                    edges_.push_back(buffer.items[i]);
+                } else if (edge.weight < edges[it->second].weight) {
+                    edges[it->second] = edge;
+                    edges_[it->second] = buffer.items[i];
+                }
+            }
+            if (bus_edges) {
+                std::sort(bus_edges->pairs.begin(), bus_edges->pairs.end());
+                bus_edges->pairs.erase(std::unique(bus_edges->pairs.begin(), bus_edges->pairs.end()),
+                                       bus_edges->pairs.end());
+            }
+        }
+        buffer = {};
+    }
+    if (enable_updates_) {
+        pair_edges_ = std::move(pair_edges);
+    }
+
+    customization_ = RouterCustomization(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < edges.size(); ++edge_id) {
+        graph_.AddEdge(edges[edge_id]);
+        customization_.AddEdge(edges[edge_id].from, edges[edge_id].to, edges_[edge_id].distance);
+    }
+    edges_stats_.kept = edges.size();
+
+    if (time_units_per_minute_) {
+        quantized_graph_.emplace(vertex_count);
+        for (const graph::Edge<double>& edge : edges) {
+            quantized_graph_->AddEdge({edge.from, edge.to, Quantize(edge.weight)});
+        }
+    }
+
+    components_ = graph::FindConnectedComponents(graph_);
+}
+
+TransportRouter::UpdateStats TransportRouter::UpdateBus(const domain::Bus& bus) {
+    if (!enable_updates_) {
+        throw std::logic_error("TransportRouter::UpdateBus: the router was built without updates enabled\n");
+    }
+    if (bus.stops.empty()) {
+        throw std::invalid_argument("TransportRouter::UpdateBus: bus \"" + std::string(bus.name) + "\" has no stops\n");
+    }
+    EdgesBuffer buffer;
+    AddBus(bus, buffer);
+
+    BusEdges new_edges;
+    new_edges.generated = buffer.edges.size();
+    container::FlatHashMap<size_t, std::vector<RouterItem>> new_candidates;
+    for (size_t i = 0; i < buffer.edges.size(); ++i) {
+        const graph::Edge<double>& edge = buffer.edges[i];
+        if (edge.from != edge.to) {
+            const size_t key = GetPairKey(edge.from, edge.to);
+            new_candidates[key].push_back(buffer.items[i]);
+            new_edges.pairs.push_back(key);
+        }
+    }
+    std::sort(new_edges.pairs.begin(), new_edges.pairs.end());
+    new_edges.pairs.erase(std::unique(new_edges.pairs.begin(), new_edges.pairs.end()), new_edges.pairs.end());
+
+    auto is_this_bus = [&bus](const RouterItem& item) {
+        return item.name == bus.name;
+    };
+
+    // Checked before anything changes, so a rejected update leaves the router as it was
+    auto old_edges = bus_edges_.find(bus.name);
+    const std::vector<size_t> no_pairs;
+    const std::vector<size_t>& old_pairs = old_edges != bus_edges_.end() ? old_edges->second.pairs : no_pairs;
+    for (size_t key : old_pairs) {
+        if (new_candidates.count(key) == 0) {
+            const std::vector<RouterItem>& candidates = pair_candidates_.at(key);
+            if (std::all_of(candidates.begin(), candidates.end(), is_this_bus)) {
+                throw std::invalid_argument("TransportRouter::UpdateBus: bus \"" + std::string(bus.name)
+                                            + "\" is the only one between a pair of its stops\n");
+            }
+        }
+    }
+
+    std::vector<size_t> affected_pairs;
+    std::set_union(old_pairs.begin(), old_pairs.end(), new_edges.pairs.begin(), new_edges.pairs.end(),
+                   std::back_inserter(affected_pairs));
+
+    for (size_t key : affected_pairs) {
+        std::vector<RouterItem>& candidates = pair_candidates_[key];
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), is_this_bus), candidates.end());
+        auto it = new_candidates.find(key);
+        if (it != new_candidates.end()) {
+            auto position = std::find_if(candidates.begin(), candidates.end(), [&bus](const RouterItem& item) {
+                return bus.name < item.name;
+            });
+            candidates.insert(position, it->second.begin(), it->second.end());
+        }
+    }
 
-graph::Router<double> TransportRouter::MakeRouter(const request_handler::MapData& data) {
-    const std::vector<std::pair<std::string_view, geo::Coordinates>>& stops_used = data.stops_used;
+    edges_stats_.generated += new_edges.generated;
+    if (old_edges != bus_edges_.end()) {
+        edges_stats_.generated -= old_edges->second.generated;
+        old_edges->second = std::move(new_edges);
+    } else {
+        bus_edges_.emplace(bus.name, std::move(new_edges));
+    }
 
-    for (size_t i = 0; i < stops_used.size(); ++i) {
-        stop_vertexes_[stops_used[i].first] = i;
+    UpdateStats result;
+    std::vector<ChangedEdge> changed;
+    for (size_t key : affected_pairs) {
+        if (std::optional<ChangedEdge> edge = UpdatePairEdge(key)) {
+            ++(edge->old_weight ? result.reweighted_edges : result.added_edges);
+            changed.push_back(*edge);
+        }
     }
+    edges_stats_.kept = edges_.size();
 
-    for (const domain::BusForRender& bus : data.buses) {
-        assert(!bus.stops.empty());
-        AddBus(bus);
+    if (changed.empty()) {
+        return result;
+    }
+    if (result.added_edges > 0) {
+        components_ = graph::FindConnectedComponents(graph_);
     }
 
-    return graph::Router<double>(graph_);
+    // Structures over all sources are rebuilt on demand
+    batched_paths_.reset();
+    landmarks_.reset();
+    hub_labels_.reset();
+
+    result.invalidated_trees = trees_cache_.EraseIf([this, &changed](VertexId, const auto& tree) {
+        return IsStale(*tree, changed);
+    });
+    return result;
 }
 
-std::vector<double> TransportRouter::GetIntervalsTime(const std::vector<std::string_view>& stops) const {
+std::optional<TransportRouter::ChangedEdge> TransportRouter::UpdatePairEdge(size_t key) {
+    const std::vector<RouterItem>& candidates = pair_candidates_.at(key);
+    const RouterItem& best = *std::min_element(candidates.begin(), candidates.end(),
+                                               [](const RouterItem& lhs, const RouterItem& rhs) {
+                                                   return lhs.time < rhs.time;
+                                               });
+
+    auto it = pair_edges_.find(key);
+    if (it == pair_edges_.end()) {
+        const VertexId from = key / graph_.GetVertexCount();
+        const VertexId to = key % graph_.GetVertexCount();
+        const EdgeId edge_id = graph_.AddEdge({from, to, best.time});
+        if (quantized_graph_) {
+            quantized_graph_->AddEdge({from, to, Quantize(best.time)});
+        }
+        customization_.AddEdge(from, to, best.distance);
+        edges_.push_back(best);
+        pair_edges_.emplace(key, edge_id);
+        return ChangedEdge{edge_id, std::nullopt};
+    }
+
+    const EdgeId edge_id = it->second;
+    const double old_weight = graph_.GetEdge(edge_id).weight;
+    if (best.distance != edges_[edge_id].distance) {
+        customization_.SetDistance(edge_id, best.distance);
+    }
+    // Items are read when routes are answered, so a bus of the same weight needs no other changes
+    edges_[edge_id] = best;
+    if (best.time == old_weight) {
+        return std::nullopt;
+    }
+    graph_.SetEdgeWeight(edge_id, best.time);
+    if (quantized_graph_) {
+        quantized_graph_->SetEdgeWeight(edge_id, Quantize(best.time));
+    }
+    return ChangedEdge{edge_id, old_weight};
+}
+
+// A tree stays valid if it doesn't use a heavier edge and no lighter or added edge (u, v)
+// gives v a path through u as short as its own, as in ReuseStopRoutes(). Ties are dropped
+// too, so routes are the ones a new search would find.
+bool TransportRouter::IsStale(const graph::ShortestPathsTree<double>& tree,
+                              const std::vector<ChangedEdge>& changed) const {
+    for (const ChangedEdge& changed_edge : changed) {
+        const graph::Edge<double>& edge = graph_.GetEdge(changed_edge.id);
+        if (changed_edge.old_weight && edge.weight > *changed_edge.old_weight) {
+            if (tree.GetLastEdge(edge.to) == changed_edge.id) {
+                return true;
+            }
+            continue;
+        }
+        const std::optional<double> weight_from = tree.GetWeight(edge.from);
+        if (!weight_from) {
+            continue;
+        }
+        const std::optional<double> weight_to = tree.GetWeight(edge.to);
+        if (!weight_to || !(*weight_to < *weight_from + edge.weight)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<const graph::ShortestPathsTree<double>> TransportRouter::GetTree(VertexId from_id) {
+    if (const auto* cached = trees_cache_.Find(from_id)) {
+        return *cached;
+    }
+    auto tree = std::make_shared<const graph::ShortestPathsTree<double>>(graph_, from_id);
+    trees_cache_.Insert(from_id, tree);
+    return tree;
+}
+
+TransportRouter::QuantizedWeight TransportRouter::Quantize(double time) const {
+    return static_cast<QuantizedWeight>(std::llround(time * *time_units_per_minute_));
+}
+
+std::vector<int> TransportRouter::GetIntervalsDistance(const domain::RouteView<domain::Stop*>& stops) const {
+    std::vector<int> result;
+
+    for (int i = 0; i < static_cast<int>(stops.size()) - 1; ++i) {
+        result.push_back(distance_computer_.ComputeDistance(stops[i]->name, stops[i + 1]->name));
+    }
+
+    return result;
+}
+
+std::vector<double> TransportRouter::GetIntervalsTime(const std::vector<int>& distances) const {
     std::vector<double> result;
     const double MINS_IN_HOUR = 60;
     const double METERS_IN_KM = 1000;
 
-    for (int i = 0; i < static_cast<int>(stops.size()) - 1; ++i) {
-        double distance_km = distance_computer_.ComputeDistance(stops[i], stops[i + 1]) / METERS_IN_KM;
+    for (int distance : distances) {
+        double distance_km = distance / METERS_IN_KM;
         double time = (distance_km / bus_velocity_) * MINS_IN_HOUR;
         result.push_back(time);
     }
@@ -64,34 +325,49 @@ std::vector<double> TransportRouter::GetIntervalsTime(const std::vector<std::str
     return result;
 }
 
-double TransportRouter::ComputeTimeSum(const std::vector<double>& times, size_t from, size_t to) const {
-    double res = 0;
-
-    for (; from < to; ++from) {
-        res += times[from];
-    }
+// Times of all edges from stop i are running sums over the following intervals,
+// so a bus with k stops costs O(k^2) instead of O(k^3)
+void TransportRouter::AddBus(const domain::Bus& bus, EdgesBuffer& buffer) const {
+    const domain::RouteView<domain::Stop*> stops = bus.GetRoute();
 
-    return res;
-}
+    std::vector<VertexId> stop_ids(stops.size());
+    std::transform(stops.begin(), stops.end(), stop_ids.begin(),
+                   [this](const domain::Stop* stop) {
+                       return GetVertexId(stop->name);
+                   });
 
-void TransportRouter::AddBus(const domain::BusForRender& bus) {
-    const std::vector<std::string_view>& stop_names = bus.stops;
+    std::vector<int> intervals_distance = GetIntervalsDistance(stops);
+    std::vector<double> intervals_time = GetIntervalsTime(intervals_distance);
 
-    std::vector<double> intervals_time = GetIntervalsTime(stop_names);
+    const size_t last_index = stops.size() - 1;
 
-    int last_index = static_cast<int>(stop_names.size()) - 1;
+    auto add_edge = [&](size_t from, size_t to, double time, int64_t distance) {
+        const double weight = time + wait_time_;
+        buffer.edges.push_back({stop_ids[from], stop_ids[to], weight});
+        buffer.items.push_back({bus.name, stops[from]->name, weight, static_cast<int>(to - from), distance});
+    };
 
-    for (int i = 1; i < last_index; ++i) {
-        AddEdge(stop_names[0], stop_names[i], bus.name, i,
-                ComputeTimeSum(intervals_time, 0, i) + wait_time_);
+    if (last_index > 1) {
+        const size_t edges_number = (last_index - 1) + (last_index - 1) * last_index / 2;
+        buffer.edges.reserve(buffer.edges.size() + edges_number);
+        buffer.items.reserve(buffer.items.size() + edges_number);
     }
 
-    for (int i = 1; i < last_index; ++i) {
-        std::string_view from_name = stop_names[i];
+    double time = 0;
+    int64_t distance = 0;
+    for (size_t i = 1; i < last_index; ++i) {
+        time += intervals_time[i - 1];
+        distance += intervals_distance[i - 1];
+        add_edge(0, i, time, distance);
+    }
 
-        for (int j = i + 1; j <= last_index; ++j) {
-            AddEdge(from_name, stop_names[j], bus.name, j - i,
-                    ComputeTimeSum(intervals_time, i, j) + wait_time_);
+    for (size_t i = 1; i < last_index; ++i) {
+        time = 0;
+        distance = 0;
+        for (size_t j = i + 1; j <= last_index; ++j) {
+            time += intervals_time[j - 1];
+            distance += intervals_distance[j - 1];
+            add_edge(i, j, time, distance);
         }
     }
 }
@@ -104,91 +380,435 @@ VertexId TransportRouter::GetVertexId(std::string_view vertex_name) const {
     return it->second;
 }
 
-void TransportRouter::AddEdge(std::string_view from, std::string_view to,
-             std::string_view bus_name, int stops_count, double weight) {
-    VertexId from_id = GetVertexId(from);
-    VertexId to_id   = GetVertexId(to);
+RouterSerializationData TransportRouter::GetSerializationData() {
+    if (landmarks_count_) {
+        if (!landmarks_) {
+            landmarks_.emplace(graph_, *landmarks_count_);
+        }
+        return {stop_vertexes_,
+                edges_,
+                graph_,
+                components_,
+                nullptr,
+                wait_time_,
+                bus_velocity_,
+                &*landmarks_};
+    }
 
-    graph::Edge<double> edge{from_id, to_id, weight};
-    edge.from = from_id;
-    edge.to = to_id;
-    graph_.AddEdge(edge);
+    if (use_hub_labels_) {
+        if (!hub_labels_) {
+            hub_labels_.emplace(graph_);
+        }
+        return {stop_vertexes_,
+                edges_,
+                graph_,
+                components_,
+                nullptr,
+                wait_time_,
+                bus_velocity_,
+                nullptr,
+                &*hub_labels_};
+    }
 
-    RouterItem item;
-    item.name  = bus_name;
-    item.start = from;
-    item.time  = weight;
-    item.count = stops_count;
+    if (!quantized_graph_ && !batched_paths_) {
+        batched_paths_.emplace(graph_);
+    }
+    return {stop_vertexes_,
+            edges_,
+            graph_,
+            components_,
+            [this](VertexId begin, VertexId end) {
+                std::vector<VertexId> sources(end - begin);
+                std::iota(sources.begin(), sources.end(), begin);
+                return SearchStopsRoutes(sources);
+            },
+            wait_time_,
+            bus_velocity_};
+}
 
-    edges_.push_back(item);
+RouterSerializationData TransportRouter::GetSerializationData(const LazyRouterData& previous) {
+    if (landmarks_count_ || use_hub_labels_) {
+        return GetSerializationData();
+    }
+    if (!quantized_graph_ && !batched_paths_) {
+        batched_paths_.emplace(graph_);
+    }
+    auto previous_routes = std::make_shared<const PreviousRoutes>(*this, previous);
+    return {stop_vertexes_,
+            edges_,
+            graph_,
+            components_,
+            [this, previous_routes](VertexId begin, VertexId end) {
+                std::vector<StopRoutes> result(end - begin);
+                std::vector<VertexId> sources;
+                for (VertexId from_id = begin; from_id < end; ++from_id) {
+                    if (std::optional<StopRoutes> routes = ReuseStopRoutes(*previous_routes, from_id)) {
+                        result[from_id - begin] = std::move(*routes);
+                    } else {
+                        sources.push_back(from_id);
+                    }
+                }
+                std::vector<StopRoutes> found = SearchStopsRoutes(sources);
+                for (size_t i = 0; i < sources.size(); ++i) {
+                    result[sources[i] - begin] = std::move(found[i]);
+                }
+                return result;
+            },
+            wait_time_,
+            bus_velocity_};
 }
 
+template <typename Weight>
+StopRoutes TransportRouter::MakeStopRoutes(const graph::ShortestPathsTree<Weight>& tree) const {
+    StopRoutes result;
+    const size_t vertex_count = graph_.GetVertexCount();
+    for (VertexId to_id = 0; to_id < vertex_count; ++to_id) {
+        if (tree.GetSource() != to_id) {
+            if (std::optional<WholeRoute> route = BuildRoute(tree, to_id)) {
+                result.push_back({to_id, std::move(*route)});
+            }
+        }
+    }
+    return result;
+}
 
-std::unordered_map<VertexId, StopRoutes> TransportRouter::MakeBaseData() {
-    std::unordered_map<VertexId, StopRoutes> result;
-    for (auto [from_name, from_id] : stop_vertexes_) {
-        StopRoutes& routes = result[from_id];
-        for (auto [to_name, to_id] : stop_vertexes_) {
-            if (from_id != to_id) {
-                auto route = router_.BuildRoute(from_id, to_id);
-                if (route) {
-                    routes[to_id].time = route->weight;
-                    routes[to_id].edges_ids = std::move(route->edges);
-                }
+template <typename Weight>
+std::optional<WholeRoute> TransportRouter::BuildRoute(const graph::ShortestPathsTree<Weight>& tree,
+                                                      VertexId to_id) const {
+    auto route = tree.BuildRoute(to_id);
+    if (!route) {
+        return std::nullopt;
+    }
+    if constexpr (std::is_same_v<Weight, QuantizedWeight>) {
+        // Exact times of the edges, so the total is the sum of the route items
+        double time = 0;
+        for (EdgeId edge_id : route->edges) {
+            time += graph_.GetEdge(edge_id).weight;
+        }
+        return WholeRoute{time, std::move(route->edges)};
+    } else {
+        return WholeRoute{route->weight, std::move(route->edges)};
+    }
+}
+
+StopRoutes TransportRouter::MakeStopRoutes(const BatchedPaths::Trees& trees, size_t lane) const {
+    StopRoutes result;
+    const VertexId from_id = trees.GetSource(lane);
+    for (VertexId to_id = 0; to_id < graph_.GetVertexCount(); ++to_id) {
+        if (from_id != to_id) {
+            if (auto route = trees.BuildRoute(lane, to_id)) {
+                result.push_back({to_id, {route->weight, std::move(route->edges)}});
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<StopRoutes> TransportRouter::SearchStopsRoutes(const std::vector<VertexId>& sources) const {
+    std::vector<StopRoutes> result;
+    result.reserve(sources.size());
+
+    if (!batched_paths_) {
+        for (VertexId from_id : sources) {
+            result.push_back(SearchStopRoutes(from_id));
+        }
+        return result;
+    }
+
+    for (size_t begin = 0; begin < sources.size(); begin += BatchedPaths::LANES_NUMBER) {
+        const size_t end = std::min(sources.size(), begin + BatchedPaths::LANES_NUMBER);
+        const BatchedPaths::Trees trees = batched_paths_->Search({sources.begin() + begin, sources.begin() + end});
+        for (size_t lane = 0; lane < trees.GetSourcesCount(); ++lane) {
+            result.push_back(MakeStopRoutes(trees, lane));
+        }
+    }
+    return result;
+}
+
+StopRoutes TransportRouter::SearchStopRoutes(VertexId from_id) const {
+    if (quantized_graph_) {
+        return MakeStopRoutes(graph::ShortestPathsTree<QuantizedWeight>(*quantized_graph_, from_id));
+    }
+    return MakeStopRoutes(graph::ShortestPathsTree<double>(graph_, from_id));
+}
+
+TransportRouter::PreviousRoutes::PreviousRoutes(const TransportRouter& router, const LazyRouterData& data)
+    : data(data),
+      vertex_count(data.stops_ids.size()),
+      vertexes(vertex_count),
+      old_vertexes(router.graph_.GetVertexCount()),
+      edges(data.edges.size())
+{
+    for (auto [name, id] : data.stops_ids) {
+        auto it = router.stop_vertexes_.find(name);
+        if (it != router.stop_vertexes_.end()) {
+            vertexes.at(id) = it->second;
+            old_vertexes.at(it->second) = id;
+        }
+    }
+
+    std::vector<std::string_view> bus_by_id(data.buses_ids.size());
+    for (auto [name, id] : data.buses_ids) {
+        bus_by_id.at(id) = name;
+    }
+
+    container::FlatHashMap<EdgeKey, EdgeId, EdgeKeyHasher> current_edges;
+    current_edges.reserve(router.edges_.size());
+    for (EdgeId id = 0; id < router.edges_.size(); ++id) {
+        const RouterItem& item = router.edges_[id];
+        const graph::Edge<double>& edge = router.graph_.GetEdge(id);
+        current_edges.insert({{edge.from, edge.to, item.name, item.count, item.time}, id});
+    }
+
+    std::vector<bool> has_previous(router.edges_.size(), false);
+    for (const auto& [id, item] : data.edges) {
+        std::optional<VertexId> from = vertexes.at(item.start);
+        std::optional<VertexId> to   = vertexes.at(item.finish);
+        if (!from || !to) {
+            continue;
+        }
+        auto it = current_edges.find({*from, *to, bus_by_id.at(item.name), item.count, item.time});
+        if (it != current_edges.end()) {
+            edges.at(id) = it->second;
+            has_previous[it->second] = true;
+        }
+    }
+
+    for (const auto& [key, id] : current_edges) {
+        if (!has_previous[id]) {
+            changed_edges.push_back(id);
+        }
+    }
+    std::sort(changed_edges.begin(), changed_edges.end());
+}
+
+// Old routes stay shortest if all their edges still exist and no changed edge (u, v)
+// gives v a shorter path through u. Then old weights are still a feasible potential
+// for the new graph and are reached by existing paths.
+std::optional<StopRoutes> TransportRouter::ReuseStopRoutes(const PreviousRoutes& previous,
+                                                           VertexId from_id) const {
+    const std::optional<VertexId> old_from_id = previous.old_vertexes[from_id];
+    // Bases with landmarks or hub labels have no routes table
+    if (!old_from_id || previous.data.routes.empty()) {
+        return std::nullopt;
+    }
+
+    std::vector<std::optional<double>> old_weights(graph_.GetVertexCount());
+    old_weights[from_id] = 0;
+
+    StopRoutes result;
+
+    for (size_t old_to_id = 0; old_to_id < previous.vertex_count; ++old_to_id) {
+        const std::optional<size_t> index = previous.data.pairs_index.GetIndex(*old_from_id, old_to_id);
+        if (!index || previous.data.routes.at(*index).total_time < 0) {
+            continue;
+        }
+        const RouteSpan& span = previous.data.routes[*index];
+        const std::optional<VertexId> to_id = previous.vertexes[old_to_id];
+        if (!to_id) {
+            return std::nullopt;
+        }
+
+        WholeRoute route{span.total_time, {}};
+        route.edges_ids.reserve(span.size);
+        for (uint32_t i = span.begin; i < span.begin + span.size; ++i) {
+            const std::optional<EdgeId> edge_id = previous.edges.at(previous.data.route_edges.at(i));
+            if (!edge_id) {
+                return std::nullopt;
             }
+            route.edges_ids.push_back(*edge_id);
         }
+
+        old_weights[*to_id] = span.total_time;
+        result.push_back({*to_id, std::move(route)});
     }
+
+    for (EdgeId edge_id : previous.changed_edges) {
+        const graph::Edge<double>& edge = graph_.GetEdge(edge_id);
+        const std::optional<double>& weight_from = old_weights[edge.from];
+        const std::optional<double>& weight_to   = old_weights[edge.to];
+        if (!weight_from) {
+            continue;
+        }
+        if (!weight_to) {
+            return std::nullopt;
+        }
+        // Quantized routes are compared the way they are searched
+        const bool is_shortcut = quantized_graph_
+                ? Quantize(*weight_from) + quantized_graph_->GetEdge(edge_id).weight < Quantize(*weight_to)
+                : *weight_from + edge.weight < *weight_to;
+        if (is_shortcut) {
+            return std::nullopt;
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+
     return result;
 }
 
 RouterItems TransportRouter::FindRoute(std::string_view from, std::string_view to) {
+    return FindRoutes(from, {to}).front();
+}
+
+RouterItems TransportRouter::FindRoute(std::string_view from, std::string_view to, const RoutingMetric& metric) {
+    if (metric == RoutingMetric{wait_time_, bus_velocity_}) {
+        return FindRoute(from, to);
+    }
+
     RouterItems result;
     if (from == to) {
         result.total_time = 0;
         return result;
     }
 
-    VertexId from_id, to_id;
-
-    try {
-        from_id = GetVertexId(from);
-    } catch (std::invalid_argument& e) {
+    const std::optional<VertexId> from_id = GetStopId(from);
+    const std::optional<VertexId> to_id = GetStopId(to);
+    if (!from_id || !to_id || components_[*from_id] != components_[*to_id]) {
         return result;
     }
 
-    try {
-        to_id   = GetVertexId(to);
-    } catch (std::invalid_argument& e) {
+    const std::optional<RouterCustomization::RouteInfo> route = customization_.FindRoute(*from_id, *to_id, metric);
+    if (!route) {
         return result;
     }
-    return FindRouteById(from_id, to_id);
+    result = MakeRouterItems(route->edges, route->weight);
+    for (size_t i = 0; i < route->edges.size(); ++i) {
+        result.items[i].time = customization_.GetWeight(route->edges[i], metric);
+    }
+    return result;
+}
+
+std::vector<RouterItems> TransportRouter::FindParetoRoutes(std::string_view from, std::string_view to,
+                                                          size_t max_transfers, const RoutingMetric& metric) {
+    if (from == to) {
+        RouterItems route;
+        route.total_time = 0;
+        return {route};
+    }
+    const std::optional<VertexId> from_id = GetStopId(from);
+    const std::optional<VertexId> to_id = GetStopId(to);
+    if (!from_id || !to_id || components_[*from_id] != components_[*to_id]) {
+        return {};
+    }
+
+    std::shared_ptr<const graph::DirectedWeightedGraph<double>> customized;
+    if (!(metric == RoutingMetric{wait_time_, bus_velocity_})) {
+        customized = customization_.Customize(metric);
+    }
+    const graph::DirectedWeightedGraph<double>& searched_graph = customized ? *customized : graph_;
+
+    std::vector<RouterItems> result;
+    for (const graph::ParetoRoute<double>& route : graph::FindParetoRoutes(searched_graph, *from_id, *to_id, max_transfers + 1)) {
+        result.push_back(MakeRouterItems(route.edges, route.weight));
+        for (size_t i = 0; i < route.edges.size(); ++i) {
+            result.back().items[i].time = searched_graph.GetEdge(route.edges[i]).weight;
+        }
+    }
+    return result;
+}
+
+// All routes share one single-source search
+std::vector<RouterItems> TransportRouter::FindRoutes(std::string_view from,
+                                                     const std::vector<std::string_view>& to) {
+    std::vector<RouterItems> result(to.size());
+
+    const std::optional<VertexId> from_id = GetStopId(from);
+    std::shared_ptr<const graph::ShortestPathsTree<double>> tree;
+    std::optional<graph::ShortestPathsTree<QuantizedWeight>> quantized_tree;
+
+    for (size_t i = 0; i < to.size(); ++i) {
+        if (from == to[i]) {
+            result[i].total_time = 0;
+            continue;
+        }
+
+        const std::optional<VertexId> to_id = GetStopId(to[i]);
+        if (!from_id || !to_id || components_[*from_id] != components_[*to_id]) {
+            continue;
+        }
+
+        std::optional<WholeRoute> route;
+        if (quantized_graph_) {
+            if (!quantized_tree) {
+                quantized_tree.emplace(*quantized_graph_, *from_id);
+            }
+            route = BuildRoute(*quantized_tree, *to_id);
+        } else {
+            if (!tree) {
+                tree = GetTree(*from_id);
+            }
+            route = BuildRoute(*tree, *to_id);
+        }
+
+        if (route) {
+            result[i] = MakeRouterItems(route->edges_ids, route->time);
+        }
+    }
+
+    return result;
+}
+
+std::optional<VertexId> TransportRouter::GetStopId(std::string_view name) const {
+    auto it = stop_vertexes_.find(name);
+    if (it == stop_vertexes_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
 }
 
 LazyRouter::LazyRouter(LazyRouterData& data) : RouterBase(data.wait_time, data.bus_velocity) {
-    stop_ids_.reserve(data.stops_ids.size());
-    stop_by_id_.reserve(data.stops_ids.size());
-    bus_ids_.reserve(data.buses_ids.size());
-    bus_by_id_.reserve(data.buses_ids.size());
+    const size_t vertex_count = data.stops_ids.size();
+
+    stop_ids_.reserve(vertex_count);
+    stop_by_id_.resize(vertex_count);
+    bus_by_id_.resize(data.buses_ids.size());
+    edges_.resize(data.edges.size());
 
     for (auto [name, id] : data.stops_ids) {
         stop_ids_[name] = id;
-        stop_by_id_[id] = name;
+        stop_by_id_.at(id) = name;
     }
 
     for (auto [name, id] : data.buses_ids) {
-        bus_ids_[name] = id;
-        bus_by_id_[id] = name;
+        bus_by_id_.at(id) = name;
     }
 
     for (auto& [id, item] : data.edges) {
-        edges_.push_back(std::move(item));
-        edge_ids_[id] = &edges_.back();
+        edges_.at(id) = item;
+    }
+
+    customization_ = RouterCustomization(vertex_count);
+    for (const DeserializedRouterItem& item : edges_) {
+        customization_.AddEdge(item.start, item.finish, item.distance);
     }
 
-    from_to_routes_ = std::move(data.routes);
+    pairs_index_ = std::move(data.pairs_index);
+    if (pairs_index_.GetVertexCount() != vertex_count) {
+        throw std::runtime_error("LazyRouter: components don't match stops number\n");
+    }
+
+    if (data.landmarks || data.hub_labels) {
+        landmarks_ = std::move(data.landmarks);
+        hub_labels_ = std::move(data.hub_labels);
+        if (landmarks_ && landmarks_->GetDistancesTo().size() != landmarks_->GetVertexes().size() * vertex_count) {
+            throw std::runtime_error("LazyRouter: landmarks tables don't match stops number\n");
+        }
+        if (hub_labels_ && hub_labels_->GetVertexCount() != vertex_count) {
+            throw std::runtime_error("LazyRouter: hub labels don't match stops number\n");
+        }
+        GetGraph();
+        return;
+    }
+
+    routes_ = std::move(data.routes);
+    route_edges_ = std::move(data.route_edges);
 
-    wait_time_ = data.wait_time;
-    bus_velocity_ = data.bus_velocity;
+    if (routes_.size() != pairs_index_.GetPairsCount()) {
+        throw std::runtime_error("LazyRouter: routes table doesn't match stops number\n");
+    }
 }
 
 RouterItems LazyRouter::FindRoute(std::string_view from, std::string_view to) {
@@ -206,35 +826,130 @@ RouterItems LazyRouter::FindRoute(std::string_view from, std::string_view to) {
         return result;
     }
 
-    size_t from_id = it_from->second;
-    size_t to_id   = it_to->second;
+    const std::optional<size_t> index = pairs_index_.GetIndex(it_from->second, it_to->second);
+    if (!index) {
+        return result;
+    }
+
+    if (landmarks_) {
+        return MakeRouterItems(landmarks_->FindRoute(*graph_, it_from->second, it_to->second));
+    }
+    if (hub_labels_) {
+        return MakeRouterItems(hub_labels_->BuildRoute(*graph_, it_from->second, it_to->second));
+    }
 
-    auto it_from_to = from_to_routes_.at(from_id).find(to_id);
+    const RouteSpan& route = routes_[*index];
 
-    if (it_from_to == from_to_routes_.at(from_id).end()) {
+    result.total_time = route.total_time;
+
+    result.items.reserve(route.size);
+
+    for (uint32_t i = route.begin; i < route.begin + route.size; ++i) {
+        result.items.push_back(ConvertRouterItem(route_edges_[i]));
+    }
+    return result;
+}
+
+RouterItems LazyRouter::FindRoute(std::string_view from, std::string_view to, const RoutingMetric& metric) {
+    if (metric == RoutingMetric{wait_time_, bus_velocity_}) {
+        return FindRoute(from, to);
+    }
+
+    RouterItems result;
+    if (from == to) {
+        result.total_time = 0;
+        return result;
+    }
+
+    const std::optional<VertexId> from_id = GetStopId(from);
+    const std::optional<VertexId> to_id = GetStopId(to);
+    if (!from_id || !to_id || !pairs_index_.GetIndex(*from_id, *to_id)) {
+        return result;
+    }
+
+    const std::optional<RouterCustomization::RouteInfo> route = customization_.FindRoute(*from_id, *to_id, metric);
+    result = MakeRouterItems(route);
+    for (size_t i = 0; i < result.items.size(); ++i) {
+        result.items[i].time = customization_.GetWeight(route->edges[i], metric);
+    }
+    return result;
+}
+
+std::vector<RouterItems> LazyRouter::FindParetoRoutes(std::string_view from, std::string_view to,
+                                                     size_t max_transfers, const RoutingMetric& metric) {
+    if (from == to) {
+        RouterItems route;
+        route.total_time = 0;
+        return {route};
+    }
+    const std::optional<VertexId> from_id = GetStopId(from);
+    const std::optional<VertexId> to_id = GetStopId(to);
+    if (!from_id || !to_id || !pairs_index_.GetIndex(*from_id, *to_id)) {
         return {};
     }
 
-    DeserializedRouterItems& route = it_from_to->second;
+    std::shared_ptr<const graph::DirectedWeightedGraph<double>> customized;
+    if (!(metric == RoutingMetric{wait_time_, bus_velocity_})) {
+        customized = customization_.Customize(metric);
+    }
+    const graph::DirectedWeightedGraph<double>& searched_graph = customized ? *customized : GetGraph();
+
+    std::vector<RouterItems> result;
+    for (const graph::ParetoRoute<double>& route : graph::FindParetoRoutes(searched_graph, *from_id, *to_id, max_transfers + 1)) {
+        RouterItems& items = result.emplace_back();
+        items.total_time = route.weight;
+        items.items.reserve(route.edges.size());
+        for (EdgeId edge_id : route.edges) {
+            items.items.push_back(ConvertRouterItem(edge_id));
+            items.items.back().time = searched_graph.GetEdge(edge_id).weight;
+        }
+    }
+    return result;
+}
+
+const graph::DirectedWeightedGraph<double>& LazyRouter::GetGraph() {
+    if (!graph_) {
+        graph_.emplace(stop_by_id_.size());
+        for (const DeserializedRouterItem& item : edges_) {
+            graph_->AddEdge({item.start, item.finish, item.time});
+        }
+    }
+    return *graph_;
+}
 
-    result.total_time = route.total_time;
+std::optional<VertexId> LazyRouter::GetStopId(std::string_view name) const {
+    auto it = stop_ids_.find(name);
+    if (it == stop_ids_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
 
-    result.items.reserve(route.items.size());
+template <typename RouteInfo>
+RouterItems LazyRouter::MakeRouterItems(const std::optional<RouteInfo>& route) const {
+    RouterItems result;
+
+    if (!route) {
+        return result;
+    }
 
-    for (size_t item : route.items) {
-        result.items.push_back(ConvertRouterItem(item));
+    result.total_time = route->weight;
+    result.items.reserve(route->edges.size());
+    for (EdgeId edge_id : route->edges) {
+        result.items.push_back(ConvertRouterItem(edge_id));
     }
     return result;
 }
 
-RouterItem LazyRouter::ConvertRouterItem(size_t item_id) {
+RouterItem LazyRouter::ConvertRouterItem(size_t item_id) const {
     RouterItem result;
-    DeserializedRouterItem& item = *edge_ids_[item_id];
+    const DeserializedRouterItem& item = edges_[item_id];
 
     result.count = item.count;
     result.time  = item.time;
-    result.start = stop_by_id_.at(item.start);
-    result.name  = bus_by_id_.at(item.name);
+    result.distance = item.distance;
+    result.start = stop_by_id_[item.start];
+    result.name  = bus_by_id_[item.name];
     return result;
 }
 
@@ -3,11 +3,20 @@
 #include "request_handler.h"
 #include "graph.h"
 #include "router.h"
+#include "shortest_paths.h"
+#include "batched_paths.h"
+#include "components.h"
+#include "pareto_routes.h"
+#include "lru_cache.h"
+#include "flat_hash_map.h"
 #include <string_view>
 #include "domain.h"
 #include <set>
 #include <vector>
-#include <unordered_map>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <cstdint>
 
 namespace transport_router {
 
@@ -16,50 +25,203 @@ using EdgeId = size_t;
 
 class TransportRouter : public RouterBase {
 public:
+    struct EdgesStats {
+        size_t generated = 0;   // edges made from bus routes
+        size_t kept = 0;        // edges left after removing loops and dominated parallel edges
+    };
+
+    struct UpdateStats {
+        size_t added_edges = 0;         // pairs of stops connected for the first time
+        size_t reweighted_edges = 0;    // existing edges whose weight changed
+        size_t invalidated_trees = 0;   // cached shortest paths trees dropped
+    };
+
     TransportRouter(request_handler::RoutingSettings settings,
                     const request_handler::DistanceComputer& distance_computer,
-                    const request_handler::MapData& data)
+                    const request_handler::MapData& data,
+                    bool enable_updates = false)
                                 : RouterBase(settings.wait_time, settings.bus_velocity),
                                   distance_computer_(distance_computer),
                                   graph_ (data.stops_used.size()),
-                                  router_(MakeRouter(data)) {}
-
-    RouterSerializationData GetSerializationData() override {
-        return {stop_vertexes_,
-                edges_,
-                MakeBaseData(),
-                wait_time_,
-                bus_velocity_};
+                                  time_units_per_minute_(settings.time_units_per_minute),
+                                  landmarks_count_(settings.landmarks_count),
+                                  use_hub_labels_(settings.hub_labels),
+                                  enable_updates_(enable_updates) {
+        BuildGraph(data);
     }
 
+    RouterSerializationData GetSerializationData() override;
+
+    // Same as GetSerializationData(), but rows of sources whose shortest paths can't be
+    // affected by the difference between the graphs are taken from the previous base
+    RouterSerializationData GetSerializationData(const LazyRouterData& previous);
+
     RouterItems FindRoute(std::string_view from, std::string_view to) override;
 
+    RouterItems FindRoute(std::string_view from, std::string_view to, const RoutingMetric& metric) override;
+
+    std::vector<RouterItems> FindParetoRoutes(std::string_view from, std::string_view to,
+                                              size_t max_transfers, const RoutingMetric& metric) override;
+
+    std::vector<RouterItems> FindRoutes(std::string_view from,
+                                        const std::vector<std::string_view>& to) override;
+
+    bool IsBatchingRoutes() const override {
+        return true;
+    }
+
+    std::optional<VertexId> GetStopId(std::string_view name) const override;
+
+    EdgesStats GetEdgesStats() const {
+        return edges_stats_;
+    }
+
+    // Rebuilds edges of one bus, new or changed, with current distances. Only pairs of stops
+    // the bus serves before or after the update are reweighted, and only cached trees the change
+    // can affect are dropped. Stops of the bus should be known to the router already, and every
+    // pair the bus stops serving should still be served by some other bus, as edges are never
+    // removed. Names of the bus and its stops should outlive the router. The router should be
+    // built with enable_updates, otherwise candidate edges of pairs aren't kept for it.
+    UpdateStats UpdateBus(const domain::Bus& bus);
+
+    // Number of single-source trees kept for FindRoutes() over double weights
+    static const size_t TREE_CACHE_CAPACITY = 64;
+
 private:
-    RouterItems FindRouteById(VertexId from_id, VertexId to_id);
+    // Previous base data mapped to current vertex and edge ids
+    struct PreviousRoutes {
+        PreviousRoutes(const TransportRouter& router, const LazyRouterData& data);
+
+        const LazyRouterData& data;
+        size_t vertex_count;
+        std::vector<std::optional<VertexId>> vertexes;      // previous vertex id -> current one
+        std::vector<std::optional<VertexId>> old_vertexes;  // current vertex id -> previous one
+        std::vector<std::optional<EdgeId>> edges;           // previous edge id -> equal current edge
+        std::vector<EdgeId> changed_edges;                  // current edges absent in previous base
+    };
+
+    struct EdgeKey {
+        VertexId from;
+        VertexId to;
+        std::string_view bus_name;
+        int count;
+        double time;
+
+        bool operator==(const EdgeKey& other) const {
+            return from == other.from && to == other.to && bus_name == other.bus_name
+                   && count == other.count && time == other.time;
+        }
+    };
+
+    struct EdgeKeyHasher {
+        size_t operator()(const EdgeKey& key) const {
+            return key.from + key.to * 37 + std::hash<std::string_view>{}(key.bus_name) * 37 * 37
+                   + key.count * 7919 + std::hash<double>{}(key.time) * 3571;
+        }
+    };
+
+    // Edge weights in 1/time_units_per_minute_ of a minute
+    using QuantizedWeight = uint64_t;
+
+    RouterItems MakeRouterItems(const std::vector<EdgeId>& edges, double weight) const;
+
+    void BuildGraph(const request_handler::MapData& data);
+
+    // Edges of consecutive buses, filled by one thread while the graph is built
+    struct EdgesBuffer {
+        std::vector<graph::Edge<double>> edges;
+        std::vector<RouterItem> items;
+        // End of edges of every bus in the buffer
+        std::vector<size_t> bus_ends;
+    };
+
+    // Candidate edges generated by one bus
+    struct BusEdges {
+        size_t generated = 0;
+        std::vector<size_t> pairs;  // sorted keys of pairs of distinct stops
+    };
 
-    graph::Router<double> MakeRouter(const request_handler::MapData& data);
+    size_t GetPairKey(VertexId from, VertexId to) const {
+        return from * graph_.GetVertexCount() + to;
+    }
+
+    struct ChangedEdge {
+        EdgeId id;
+        std::optional<double> old_weight;   // std::nullopt for an added edge
+    };
+
+    // Makes the first lightest candidate of the pair its edge, adding the edge if there was none
+    std::optional<ChangedEdge> UpdatePairEdge(size_t key);
+
+    // Whether the tree may be not the shortest paths one after the edges changed
+    bool IsStale(const graph::ShortestPathsTree<double>& tree, const std::vector<ChangedEdge>& changed) const;
 
-    std::vector<double> GetIntervalsTime(const std::vector<std::string_view>& stops) const;
+    std::shared_ptr<const graph::ShortestPathsTree<double>> GetTree(VertexId from_id);
 
-    double ComputeTimeSum(const std::vector<double>& times, size_t from, size_t to) const;
+    std::vector<int> GetIntervalsDistance(const domain::RouteView<domain::Stop*>& stops) const;
 
-    void AddBus(const domain::BusForRender& bus);
+    std::vector<double> GetIntervalsTime(const std::vector<int>& distances) const;
+
+    void AddBus(const domain::Bus& bus, EdgesBuffer& buffer) const;
 
     VertexId GetVertexId(std::string_view vertex_name) const;
 
-    void AddEdge(std::string_view from, std::string_view to,
-                 std::string_view bus_name, int stops_count, double weight);
+    template <typename Weight>
+    StopRoutes MakeStopRoutes(const graph::ShortestPathsTree<Weight>& tree) const;
+
+    template <typename Weight>
+    std::optional<WholeRoute> BuildRoute(const graph::ShortestPathsTree<Weight>& tree, VertexId to_id) const;
+
+    using BatchedPaths = graph::BatchedShortestPaths<double>;
 
-    std::unordered_map<VertexId, StopRoutes> MakeBaseData();
+    StopRoutes MakeStopRoutes(const BatchedPaths::Trees& trees, size_t lane) const;
 
+    // Routes from one source by a single-source search, over quantized weights if they are set
+    StopRoutes SearchStopRoutes(VertexId from_id) const;
 
+    // Same for several sources, double weights are searched by batches of sources
+    std::vector<StopRoutes> SearchStopsRoutes(const std::vector<VertexId>& sources) const;
 
-    std::unordered_map<std::string_view, VertexId> stop_vertexes_;
+    QuantizedWeight Quantize(double time) const;
+
+    std::optional<StopRoutes> ReuseStopRoutes(const PreviousRoutes& previous, VertexId from_id) const;
+
+
+
+    container::FlatHashMap<std::string_view, VertexId> stop_vertexes_;
     std::vector<RouterItem> edges_;
+    EdgesStats edges_stats_;
 
     const request_handler::DistanceComputer& distance_computer_;
     graph::DirectedWeightedGraph<double> graph_;
-    graph::Router<double> router_;
+
+    // Both set if routes are searched over integer weights instead of graph_ ones
+    std::optional<int> time_units_per_minute_;
+    std::optional<graph::DirectedWeightedGraph<QuantizedWeight>> quantized_graph_;
+    // Built when rows of all sources are needed
+    std::optional<BatchedPaths> batched_paths_;
+
+    // Set if the base stores landmarks tables instead of routes of all sources
+    std::optional<int> landmarks_count_;
+    std::optional<graph::Landmarks<double>> landmarks_;
+    // Set if the base stores hub labels instead of routes of all sources
+    bool use_hub_labels_;
+    std::optional<graph::HubLabels<double>> hub_labels_;
+
+    std::vector<uint32_t> components_;                  // vertex id -> connected component id
+
+    // Road lengths of graph_ edges, for routes under other routing settings
+    RouterCustomization customization_;
+
+    bool enable_updates_;
+
+    // Kept if updates are enabled: candidate edges of every pair of stops in bus order, the first lightest
+    // one is the pair's edge, as it is in BuildGraph()
+    container::FlatHashMap<size_t, std::vector<RouterItem>> pair_candidates_;
+    container::FlatHashMap<size_t, EdgeId> pair_edges_;
+    container::FlatHashMap<std::string_view, BusEdges> bus_edges_;
+
+    cache::LruCache<VertexId, std::shared_ptr<const graph::ShortestPathsTree<double>>> trees_cache_{TREE_CACHE_CAPACITY};
 };
 
 class LazyRouter : public RouterBase {
@@ -68,22 +230,44 @@ public:
 
     RouterItems FindRoute(std::string_view from, std::string_view to) override;
 
+    RouterItems FindRoute(std::string_view from, std::string_view to, const RoutingMetric& metric) override;
+
+    std::vector<RouterItems> FindParetoRoutes(std::string_view from, std::string_view to,
+                                              size_t max_transfers, const RoutingMetric& metric) override;
+
+    std::optional<VertexId> GetStopId(std::string_view name) const override;
+
     RouterSerializationData GetSerializationData() override {
         throw std::runtime_error("GetSerializationData() not available now for LazyRouter\n");
     }
 
 private:
-    RouterItem ConvertRouterItem(size_t item_id);
-    std::deque<DeserializedRouterItem> edges_;
+    RouterItem ConvertRouterItem(size_t item_id) const;
+
+    // Graph of edges_ with their stored times
+    const graph::DirectedWeightedGraph<double>& GetGraph();
+
+    template <typename RouteInfo>
+    RouterItems MakeRouterItems(const std::optional<RouteInfo>& route) const;
+
+    container::FlatHashMap<std::string_view, size_t> stop_ids_;
+
+    std::vector<std::string_view> stop_by_id_;
+    std::vector<std::string_view> bus_by_id_;
+    std::vector<DeserializedRouterItem> edges_;
 
-    std::unordered_map<std::string_view, size_t> stop_ids_;
-    std::unordered_map<std::string_view, size_t> bus_ids_;
+    graph::ComponentPairsIndex pairs_index_;
+    std::vector<RouteSpan> routes_;
+    std::vector<uint32_t> route_edges_;
 
-    std::unordered_map<size_t, std::string_view> stop_by_id_;
-    std::unordered_map<size_t, std::string_view> bus_by_id_;
+    // One is set instead of the routes table for bases without it, graph_ is made of edges_ then,
+    // or on the first search over it otherwise
+    std::optional<graph::Landmarks<double>> landmarks_;
+    std::optional<graph::HubLabels<double>> hub_labels_;
+    std::optional<graph::DirectedWeightedGraph<double>> graph_;
 
-    std::unordered_map<size_t, DeserializedRouterItem*> edge_ids_;
-    std::unordered_map<size_t, std::unordered_map<size_t, DeserializedRouterItems>> from_to_routes_;
+    // Road lengths of edges_, for routes under other routing settings
+    RouterCustomization customization_;
 };
 
 
@@ -0,0 +1,12 @@
+#include "unit_tests.h"
+
+#include <iostream>
+
+int main() {
+    tests::TestBases();
+    tests::TestRouting();
+    tests::TestFlatHashMap();
+    tests::TestIndexes();
+    std::cout << "All tests passed\n";
+    return 0;
+}
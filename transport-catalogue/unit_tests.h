@@ -0,0 +1,18 @@
+#pragma once
+
+// Tests of the catalogue parts, every one aborts on the first failed check
+namespace tests {
+
+// make_base and process_requests over bases in files
+void TestBases();
+
+// Against std::unordered_map
+void TestFlatHashMap();
+
+// Catalogue indexes and memoized answers against brute force
+void TestIndexes();
+
+// Routing structures against plain Dijkstra searches
+void TestRouting();
+
+} //namespace tests